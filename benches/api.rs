@@ -0,0 +1,159 @@
+//! Per-call overhead of the libRebol API through the shim.
+//!
+//! Run with `cargo bench --bench api`.  Numbers are wall-clock averages
+//! over a fixed iteration count, printed as nanoseconds per call.
+
+use renc_sys::*;
+use std::os::raw::c_void;
+use std::time::Instant;
+
+const ITERATIONS: u32 = 1_000_000;
+
+fn bench<F: FnMut()>(name: &str, mut f: F) {
+    for _ in 0..ITERATIONS / 10 {
+        f(); // warm up
+    }
+    let start = Instant::now();
+    for _ in 0..ITERATIONS {
+        f();
+    }
+    let elapsed = start.elapsed();
+    let ns = elapsed.as_secs() as f64 * 1e9 + elapsed.subsec_nanos() as f64;
+    println!("{:<40} {:>10.1} ns/call", name, ns / ITERATIONS as f64);
+}
+
+fn main() {
+    unsafe {
+        rebStartup();
+        let one = rebInteger(1i64);
+        let expr = b"1 +\0".as_ptr() as *const c_void;
+
+        bench("rebValue variadic (1 + one)", || {
+            let two = rebValue(expr, one as *const c_void, feed::END);
+            rebRelease(two);
+        });
+
+        bench("rebValueArray (1 + one)", || {
+            let two = feed::value(&[expr, one as *const c_void]);
+            rebRelease(two);
+        });
+
+        let add_one = prepared::Prepared::new(&["1 +", ""]);
+        bench("rebRunPrepared (1 + one)", || {
+            let two = add_one.run(&[one]);
+            rebRelease(two);
+        });
+        drop(add_one);
+
+        bench("rebUnboxInteger variadic (one)", || {
+            rebUnboxInteger(one as *const c_void, feed::END);
+        });
+
+        bench("rebUnboxIntegerArray (one)", || {
+            feed::unbox_integer(&[one as *const c_void]);
+        });
+
+        bench("rebInteger + rebRelease", || {
+            let v = rebInteger(1i64);
+            rebRelease(v);
+        });
+
+        bench("rebUnboxInteger0", || {
+            rebUnboxInteger0(one as *const c_void);
+        });
+
+        bench("Value::integer + drop", || {
+            let _v = Value::integer(1);
+        });
+
+        let one_value = Value::integer(1);
+        bench("CString::new + rebValue (1 + one)", || {
+            let expr = std::ffi::CString::new("1 +").unwrap();
+            let two = rebValue(expr.as_ptr() as *const c_void, one as *const c_void, feed::END);
+            rebRelease(two);
+        });
+
+        bench("reb!(\"1 +\", one)", || {
+            let _two = reb!("1 +", one_value);
+        });
+
+        // What slicing costs: four expressions in one go, then a turn each
+        let four = "1 + 1 1 + 1 1 + 1 1 + 1";
+        bench("reb!(four expressions)", || {
+            let _two = reb!(feed::Fragment::new(four));
+        });
+
+        bench("Continuation (four, budget 1)", || {
+            let mut c = continuation::Continuation::new(four);
+            while !c.resume(1) {}
+        });
+
+        bench("Value::to_i64", || {
+            one_value.to_i64();
+        });
+        drop(one_value);
+
+        {
+            let s = session::Session::enter();
+
+            bench("session: rebInteger + rebRelease", || {
+                let v = s.integer(1);
+                s.release(v);
+            });
+
+            bench("session: rebUnboxInteger0", || {
+                s.unbox_integer(one);
+            });
+        }
+
+        let payload = vec![0x55u8; 64 * 1024];
+
+        bench("Value::binary (64K copied)", || {
+            let _bin = Value::binary(&payload);
+        });
+
+        bench("RebBuffer::into_binary (64K)", || {
+            let mut buf = RebBuffer::with_capacity(payload.len());
+            buf.extend_from_slice(&payload);
+            let _bin = buf.into_binary();
+        });
+
+        rebRelease(one);
+        rebShutdown(true);
+    }
+
+    #[cfg(feature = "instances")]
+    instance_scaling();
+}
+
+/// Throughput of threads each running their own interpreter, which should
+/// scale with the cores (up to glibc's 15 extra namespaces).
+#[cfg(feature = "instances")]
+fn instance_scaling() {
+    use renc_sys::instance::Instance;
+
+    let cores = std::thread::available_parallelism().map_or(1, |n| n.get());
+    for &threads in [1, 2, 4, 8, 15].iter().filter(|&&n| n <= cores.max(1)) {
+        let start = Instant::now();
+        let workers: Vec<_> = (0..threads)
+            .map(|_| {
+                std::thread::spawn(|| {
+                    let instance = Instance::new().unwrap();
+                    instance.run(|| {
+                        let one = Value::integer(1);
+                        for _ in 0..ITERATIONS / 10 {
+                            let _two = reb!("1 +", one);
+                        }
+                    })
+                })
+            })
+            .collect();
+        for worker in workers {
+            worker.join().unwrap();
+        }
+        let elapsed = start.elapsed();
+        let secs = elapsed.as_secs() as f64 + elapsed.subsec_nanos() as f64 * 1e-9;
+        let calls = threads as f64 * (ITERATIONS / 10) as f64;
+        println!("{:<40} {:>10.0} calls/s", format!("instances x{}: reb!(\"1 +\", one)", threads), calls / secs);
+    }
+}
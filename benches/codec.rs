@@ -0,0 +1,410 @@
+//! Benchmark suite for compression: every `*Alloc` entry point of the API,
+//! and the shim's codecs, over several corpora at several sizes.
+//!
+//! The `*Alloc` calls run on the backend the shim was built with (see the
+//! `deflate-*` features), and also directly on the core's when that is a
+//! different one.  Each row gives MB/s of uncompressed data, the ratio,
+//! heap allocations per call made from Rust (those inside libr3 or the
+//! shim's C code can't be seen from here), and the peak RSS of the process
+//! while the row ran (Linux only).
+//!
+//! Run with `cargo bench --bench codec [--features deflate-libdeflate]`.
+//! Set `RENC_CORPUS` to a directory of files (e.g. the Silesia corpus) to
+//! add them as real-world corpora; rebol.h is always one.  Set
+//! `RENC_BENCH_FILTER` to only run rows whose name contains it.
+
+use renc_sys::codec::{self, Codec, Decoder, Dictionary, Encoder, Format, ParallelGzip, Strategy};
+use renc_sys::*;
+use std::alloc::{GlobalAlloc, Layout, System};
+use std::ffi::CStr;
+use std::io::{Read, Write};
+use std::os::raw::{c_int, c_void};
+use std::sync::atomic::{AtomicUsize, Ordering};
+use std::time::{Duration, Instant};
+
+struct Counting;
+
+static ALLOCATIONS: AtomicUsize = AtomicUsize::new(0);
+
+unsafe impl GlobalAlloc for Counting {
+    unsafe fn alloc(&self, layout: Layout) -> *mut u8 {
+        ALLOCATIONS.fetch_add(1, Ordering::Relaxed);
+        System.alloc(layout)
+    }
+
+    unsafe fn dealloc(&self, ptr: *mut u8, layout: Layout) {
+        System.dealloc(ptr, layout)
+    }
+
+    unsafe fn realloc(&self, ptr: *mut u8, layout: Layout, new_size: usize) -> *mut u8 {
+        ALLOCATIONS.fetch_add(1, Ordering::Relaxed);
+        System.realloc(ptr, layout, new_size)
+    }
+}
+
+#[global_allocator]
+static GLOBAL: Counting = Counting;
+
+const SIZES: [usize; 4] = [1024, 64 * 1024, 1024 * 1024, 16 * 1024 * 1024];
+const MIN_TIME: Duration = Duration::from_millis(300);
+const MIN_RUNS: u32 = 3;
+
+/// Start counting the peak RSS from the current RSS.
+fn reset_peak_rss() {
+    let _ = std::fs::write("/proc/self/clear_refs", "5");
+}
+
+/// Peak RSS in MB, from /proc (so `None` elsewhere).
+fn peak_rss() -> Option<f64> {
+    let status = std::fs::read_to_string("/proc/self/status").ok()?;
+    let line = status.lines().find(|l| l.starts_with("VmHWM:"))?;
+    let kb: f64 = line.split_whitespace().nth(1)?.parse().ok()?;
+    Some(kb / 1024.0)
+}
+
+struct Suite {
+    filter: Option<String>,
+}
+
+impl Suite {
+    /// Time `f`, which processes `size` bytes of uncompressed data and
+    /// gives the compressed size.
+    fn row<F: FnMut() -> usize>(&self, op: &str, corpus: &str, size: usize, mut f: F) {
+        let name = format!("{} / {} / {}", op, corpus, human(size));
+        if let Some(ref filter) = self.filter {
+            if !name.contains(filter.as_str()) {
+                return;
+            }
+        }
+
+        f(); // warm up
+        reset_peak_rss();
+        let allocations = ALLOCATIONS.load(Ordering::Relaxed);
+        let start = Instant::now();
+        let mut runs = 0;
+        let mut compressed = 0;
+        while runs < MIN_RUNS || start.elapsed() < MIN_TIME {
+            compressed = f();
+            runs += 1;
+        }
+        let elapsed = start.elapsed();
+        let allocations = ALLOCATIONS.load(Ordering::Relaxed) - allocations;
+
+        let secs = elapsed.as_secs() as f64 + elapsed.subsec_nanos() as f64 * 1e-9;
+        let mb = size as f64 * runs as f64 / (1024.0 * 1024.0);
+        let rss = peak_rss().map_or("-".to_string(), |mb| format!("{:.1}", mb));
+        println!(
+            "{:<52} {:>9.1} MB/s  ratio {:>5.3}  {:>6.1} allocs  peak {:>7} MB",
+            name,
+            mb / secs,
+            compressed as f64 / size.max(1) as f64,
+            allocations as f64 / runs as f64,
+            rss
+        );
+    }
+}
+
+fn human(size: usize) -> String {
+    if size >= 1024 * 1024 {
+        format!("{}M", size / (1024 * 1024))
+    } else {
+        format!("{}K", size / 1024)
+    }
+}
+
+fn xorshift(seed: &mut u32) -> u32 {
+    *seed ^= *seed << 13;
+    *seed ^= *seed >> 17;
+    *seed ^= *seed << 5;
+    *seed
+}
+
+fn synthetic_log(size: usize) -> Vec<u8> {
+    let mut out = Vec::with_capacity(size + 128);
+    let mut seed = 12345;
+    while out.len() < size {
+        let r = xorshift(&mut seed);
+        writeln!(
+            out,
+            "2019-06-{:02} 12:{:02}:{:02} worker-{} handled request {} in {} us",
+            r % 28 + 1,
+            (r >> 8) % 60,
+            (r >> 14) % 60,
+            (r >> 20) % 16,
+            r,
+            (r >> 4) % 5000
+        )
+        .unwrap();
+    }
+    out.truncate(size);
+    out
+}
+
+fn synthetic_json(size: usize) -> Vec<u8> {
+    let names = ["alice", "bob", "carol", "dave", "erin", "frank"];
+    let mut out = Vec::with_capacity(size + 128);
+    let mut seed = 777;
+    while out.len() < size {
+        let r = xorshift(&mut seed);
+        writeln!(
+            out,
+            r#"{{"id": {}, "user": "{}", "score": {}.{:02}, "tags": ["t{}", "t{}"]}}"#,
+            r % 100_000,
+            names[(r >> 3) as usize % names.len()],
+            (r >> 7) % 1000,
+            (r >> 17) % 100,
+            (r >> 11) % 20,
+            (r >> 21) % 20
+        )
+        .unwrap();
+    }
+    out.truncate(size);
+    out
+}
+
+fn random(size: usize) -> Vec<u8> {
+    let mut seed = 42;
+    (0..size).map(|_| xorshift(&mut seed) as u8).collect()
+}
+
+/// (name, data, synthetic): synthetic corpora are made at the biggest
+/// size, real ones are only run at sizes they have enough data for.
+fn corpora() -> Vec<(String, Vec<u8>, bool)> {
+    let max = SIZES[SIZES.len() - 1];
+    let mut corpora = vec![
+        ("log".to_string(), synthetic_log(max), true),
+        ("json".to_string(), synthetic_json(max), true),
+        ("random".to_string(), random(max), true),
+        ("zeros".to_string(), vec![0; max], true),
+        (
+            "rebol.h".to_string(),
+            include_bytes!("../renc/include/rebol.h").to_vec(),
+            false,
+        ),
+    ];
+    if let Ok(dir) = std::env::var("RENC_CORPUS") {
+        let mut entries: Vec<_> = std::fs::read_dir(&dir)
+            .expect("RENC_CORPUS should be a directory")
+            .filter_map(|e| e.ok())
+            .filter(|e| e.path().is_file())
+            .collect();
+        entries.sort_by_key(|e| e.file_name());
+        for entry in entries {
+            let data = std::fs::read(entry.path()).unwrap();
+            corpora.push((entry.file_name().to_string_lossy().into_owned(), data, false));
+        }
+    }
+    corpora
+}
+
+type AllocCompress = fn(*mut size_t, *const c_void, size_t) -> *mut c_void;
+type AllocDecompress = fn(*mut size_t, *const c_void, size_t, c_int) -> *mut c_void;
+
+/// Input for a decompression row, made with the matching compressor.
+unsafe fn alloc_compressed(compress: AllocCompress, data: &[u8]) -> Vec<u8> {
+    let mut size: size_t = 0;
+    let out = compress(&mut size, data.as_ptr() as *const c_void, data.len() as size_t);
+    let copy = std::slice::from_raw_parts(out as *const u8, size as usize).to_vec();
+    rebFree(out);
+    copy
+}
+
+fn alloc_rows(suite: &Suite, backend: &str, corpus: &str, data: &[u8]) {
+    let size = data.len();
+    let mut compressors: Vec<(String, AllocCompress)> = vec![
+        (format!("rebDeflateAlloc [{}]", backend), |o, i, n| unsafe { rebDeflateAlloc(o, i, n) }),
+        (format!("rebZdeflateAlloc [{}]", backend), |o, i, n| unsafe { rebZdeflateAlloc(o, i, n) }),
+        (format!("rebGzipAlloc [{}]", backend), |o, i, n| unsafe { rebGzipAlloc(o, i, n) }),
+    ];
+    let mut decompressors: Vec<(String, AllocCompress, AllocDecompress)> = vec![
+        (
+            format!("rebInflateAlloc [{}]", backend),
+            |o, i, n| unsafe { rebDeflateAlloc(o, i, n) },
+            |o, i, n, m| unsafe { rebInflateAlloc(o, i, n, m) },
+        ),
+        (
+            format!("rebZinflateAlloc [{}]", backend),
+            |o, i, n| unsafe { rebZdeflateAlloc(o, i, n) },
+            |o, i, n, m| unsafe { rebZinflateAlloc(o, i, n, m) },
+        ),
+        (
+            format!("rebGunzipAlloc [{}]", backend),
+            |o, i, n| unsafe { rebGzipAlloc(o, i, n) },
+            |o, i, n, m| unsafe { rebGunzipAlloc(o, i, n, m) },
+        ),
+        (
+            format!("rebDeflateDetectAlloc zlib [{}]", backend),
+            |o, i, n| unsafe { rebZdeflateAlloc(o, i, n) },
+            |o, i, n, m| unsafe { rebDeflateDetectAlloc(o, i, n, m) },
+        ),
+        (
+            format!("rebDeflateDetectAlloc gzip [{}]", backend),
+            |o, i, n| unsafe { rebGzipAlloc(o, i, n) },
+            |o, i, n, m| unsafe { rebDeflateDetectAlloc(o, i, n, m) },
+        ),
+    ];
+    if backend != "core" {
+        compressors.extend(vec![
+            ("rebDeflateAlloc [core]".to_string(), (|o, i, n| unsafe {
+                RL_rebEnterApi_internal();
+                RL_rebDeflateAlloc(o, i, n)
+            }) as AllocCompress),
+            ("rebZdeflateAlloc [core]".to_string(), |o, i, n| unsafe {
+                RL_rebEnterApi_internal();
+                RL_rebZdeflateAlloc(o, i, n)
+            }),
+            ("rebGzipAlloc [core]".to_string(), |o, i, n| unsafe {
+                RL_rebEnterApi_internal();
+                RL_rebGzipAlloc(o, i, n)
+            }),
+        ]);
+        decompressors.extend(vec![
+            (
+                "rebInflateAlloc [core]".to_string(),
+                (|o, i, n| unsafe { rebDeflateAlloc(o, i, n) }) as AllocCompress,
+                (|o, i, n, m| unsafe {
+                    RL_rebEnterApi_internal();
+                    RL_rebInflateAlloc(o, i, n, m)
+                }) as AllocDecompress,
+            ),
+            (
+                "rebZinflateAlloc [core]".to_string(),
+                |o, i, n| unsafe { rebZdeflateAlloc(o, i, n) },
+                |o, i, n, m| unsafe {
+                    RL_rebEnterApi_internal();
+                    RL_rebZinflateAlloc(o, i, n, m)
+                },
+            ),
+            (
+                "rebGunzipAlloc [core]".to_string(),
+                |o, i, n| unsafe { rebGzipAlloc(o, i, n) },
+                |o, i, n, m| unsafe {
+                    RL_rebEnterApi_internal();
+                    RL_rebGunzipAlloc(o, i, n, m)
+                },
+            ),
+            (
+                "rebDeflateDetectAlloc gzip [core]".to_string(),
+                |o, i, n| unsafe { rebGzipAlloc(o, i, n) },
+                |o, i, n, m| unsafe {
+                    RL_rebEnterApi_internal();
+                    RL_rebDeflateDetectAlloc(o, i, n, m)
+                },
+            ),
+        ]);
+    }
+
+    for (name, compress) in compressors {
+        suite.row(&name, corpus, size, || unsafe {
+            let mut out_size: size_t = 0;
+            let out = compress(&mut out_size, data.as_ptr() as *const c_void, size as size_t);
+            rebFree(out);
+            out_size as usize
+        });
+    }
+    for (name, compress, decompress) in decompressors {
+        let packed = unsafe { alloc_compressed(compress, data) };
+        suite.row(&name, corpus, size, || unsafe {
+            let mut out_size: size_t = 0;
+            let out = decompress(&mut out_size, packed.as_ptr() as *const c_void, packed.len() as size_t, -1);
+            assert_eq!(size, out_size as usize);
+            rebFree(out);
+            packed.len()
+        });
+    }
+
+    // Same, told the format and size instead of working them out
+    for &(name, format, compress) in &[
+        ("zlib", Format::Zlib, (|o, i, n| unsafe { rebZdeflateAlloc(o, i, n) }) as AllocCompress),
+        ("gzip", Format::Gzip, |o, i, n| unsafe { rebGzipAlloc(o, i, n) }),
+    ] {
+        let packed = unsafe { alloc_compressed(compress, data) };
+        let name = format!("rebDecompressAlloc {} hinted [{}]", name, backend);
+        suite.row(&name, corpus, size, || {
+            let (out, _) = codec::decompress(&packed, Some(format), size);
+            assert_eq!(size, out.len());
+            packed.len()
+        });
+    }
+}
+
+fn codec_rows(suite: &Suite, corpus: &str, data: &[u8]) {
+    let size = data.len();
+
+    suite.row("codec::Encoder gzip", corpus, size, || {
+        let mut enc = Encoder::new(Vec::new(), Format::Gzip, -1).unwrap();
+        enc.write_all(data).unwrap();
+        enc.finish().unwrap().len()
+    });
+
+    let mut enc = Encoder::new(Vec::new(), Format::Gzip, -1).unwrap();
+    enc.write_all(data).unwrap();
+    let gz = enc.finish().unwrap();
+    let mut out = Vec::with_capacity(size);
+    suite.row("codec::Decoder gzip", corpus, size, || {
+        out.clear();
+        Decoder::new(&gz[..], Format::Gzip).unwrap().read_to_end(&mut out).unwrap();
+        gz.len()
+    });
+
+    let cores = std::thread::available_parallelism().map(|n| n.get()).unwrap_or(1);
+    let gzip = ParallelGzip::new().threads(cores);
+    suite.row(&format!("ParallelGzip x{}", cores), corpus, size, || {
+        gzip.compress(data).unwrap().len()
+    });
+
+    for &level in &[1, 6] {
+        let mut codec = Codec::compressor_with(Format::Deflate, level, Strategy::Default).unwrap();
+        let mut packed = vec![0; codec.compress_bound(size)];
+        suite.row(&format!("compress_into level {}", level), corpus, size, || {
+            codec.compress_into(data, &mut packed).unwrap()
+        });
+    }
+}
+
+/// Small messages, where the per-call setup dominates.
+fn message_rows(suite: &Suite) {
+    let log = synthetic_log(64 * 1024);
+    let message = &log[32 * 1024..32 * 1024 + 256];
+
+    suite.row("rebDeflateAlloc", "log message", 256, || unsafe {
+        let mut size: size_t = 0;
+        let out = rebDeflateAlloc(&mut size, message.as_ptr() as *const c_void, 256);
+        rebFree(out);
+        size as usize
+    });
+
+    let mut codec = Codec::compressor(Format::Zlib, 6).unwrap();
+    let mut packed = vec![0; codec.compress_bound(message.len())];
+    suite.row("compress_into zlib", "log message", 256, || {
+        codec.compress_into(message, &mut packed).unwrap()
+    });
+
+    // primed with earlier log lines, as a shared dictionary would be
+    codec.set_dictionary(Some(Dictionary::new(&log[..4096]).unwrap())).unwrap();
+    suite.row("compress_into zlib, dictionary", "log message", 256, || {
+        codec.compress_into(message, &mut packed).unwrap()
+    });
+}
+
+fn main() {
+    let suite = Suite { filter: std::env::var("RENC_BENCH_FILTER").ok() };
+
+    unsafe { rebStartup() };
+    let backend = unsafe { CStr::from_ptr(rebDeflateBackend()) }.to_string_lossy().into_owned();
+    println!("rebDeflateAlloc family backend: {}", backend);
+
+    for (corpus, data, synthetic) in corpora() {
+        for &size in &SIZES {
+            if size > data.len() && !synthetic {
+                continue;
+            }
+            let data = &data[..size.min(data.len())];
+            alloc_rows(&suite, &backend, &corpus, data);
+            codec_rows(&suite, &corpus, data);
+        }
+    }
+    message_rows(&suite);
+
+    unsafe { rebShutdown(true) };
+}
@@ -0,0 +1,87 @@
+//! Latency of short scripts sent to an `Evaluator` while long ones keep it
+//! busy, for a range of slice budgets.  The "unsliced" row has no slicing
+//! to speak of, so each short script waits out whatever long one is
+//! running.  So does the last row at any budget: its long script is one
+//! expression (a LOOP), and slices only end between expressions.
+//!
+//! Run with `cargo bench --bench latency`.  Each row gives percentiles of
+//! the time from `eval()` to the result, over every short script sent.
+
+use renc_sys::*;
+use std::sync::atomic::{AtomicBool, Ordering};
+use std::sync::Arc;
+use std::thread;
+use std::time::{Duration, Instant};
+
+const CLIENTS: usize = 4;
+const REQUESTS: usize = 200; // per client
+const LONG_EXPRESSIONS: usize = 10_000;
+
+fn main() {
+    let mut long = String::from("n: 0");
+    for _ in 0..LONG_EXPRESSIONS {
+        long.push_str(" n: n + 1");
+    }
+
+    for &slice in [1, 16, 256, usize::max_value()].iter() {
+        let name = if slice == usize::max_value() {
+            String::from("unsliced")
+        } else {
+            format!("slice {}", slice)
+        };
+        row(&name, slice, &long);
+    }
+
+    let one_expression = format!("n: 0 loop {} [n: n + 1]", LONG_EXPRESSIONS * 100);
+    row("slice 1, one long expression", 1, &one_expression);
+}
+
+/// Send short scripts from a few clients while `long` is run over and
+/// over, and print percentiles of their latency.
+fn row(name: &str, slice: usize, long: &str) {
+    let long = Arc::new(long.to_owned());
+    let evaluator = Arc::new(Evaluator::start(slice));
+    let busy = Arc::new(AtomicBool::new(true));
+
+    let heavy = {
+        let (evaluator, busy, long) = (evaluator.clone(), busy.clone(), long.clone());
+        thread::spawn(move || {
+            while busy.load(Ordering::Relaxed) {
+                evaluator::block_on(evaluator.eval(&long)).unwrap();
+            }
+        })
+    };
+
+    let clients: Vec<_> = (0..CLIENTS)
+        .map(|_| {
+            let evaluator = evaluator.clone();
+            thread::spawn(move || {
+                let mut latencies = Vec::with_capacity(REQUESTS);
+                for _ in 0..REQUESTS {
+                    let start = Instant::now();
+                    evaluator::block_on(evaluator.eval("1 + 2")).unwrap();
+                    latencies.push(start.elapsed());
+                    thread::sleep(Duration::from_micros(500));
+                }
+                latencies
+            })
+        })
+        .collect();
+
+    let mut latencies: Vec<Duration> =
+        clients.into_iter().flat_map(|c| c.join().unwrap()).collect();
+    busy.store(false, Ordering::Relaxed);
+    heavy.join().unwrap();
+    drop(evaluator);
+
+    latencies.sort();
+    let at = |p: f64| ms(latencies[((latencies.len() - 1) as f64 * p) as usize]);
+    println!(
+        "{:<40} {:>8.2} ms p50 {:>8.2} ms p99 {:>8.2} ms max",
+        name, at(0.5), at(0.99), at(1.0)
+    );
+}
+
+fn ms(d: Duration) -> f64 {
+    d.as_secs() as f64 * 1e3 + d.subsec_nanos() as f64 / 1e6
+}
@@ -0,0 +1,149 @@
+//! Startup latency: a cold `rebStartup()`, the same plus preloading
+//! scripts from source, and the same from a bundle of those scripts.  Also
+//! a restart between requests against a reset to a checkpoint, and a
+//! clean shutdown against a fast one.
+//!
+//! Run with `cargo bench --bench startup`.  Set `RENC_PRELOAD` to a
+//! directory of scripts to preload those; otherwise some generated ones
+//! are used.  Each row gives the mean and the best wall-clock time of a
+//! run.
+
+use renc_sys::*;
+use std::path::PathBuf;
+use std::time::{Duration, Instant};
+
+const RUNS: u32 = 20;
+
+fn bench<F: FnMut()>(name: &str, mut f: F) {
+    f(); // warm up the page cache
+    let mut total = Duration::from_secs(0);
+    let mut best = Duration::from_secs(u64::max_value());
+    for _ in 0..RUNS {
+        let start = Instant::now();
+        f();
+        let elapsed = start.elapsed();
+        total += elapsed;
+        best = std::cmp::min(best, elapsed);
+    }
+    let ms = |d: Duration| d.as_secs() as f64 * 1e3 + d.subsec_nanos() as f64 / 1e6;
+    println!("{:<40} {:>8.2} ms mean {:>8.2} ms best", name, ms(total) / RUNS as f64, ms(best));
+}
+
+/// Scripts to preload, from `RENC_PRELOAD` or made up in a temp directory.
+fn preload_scripts() -> Vec<PathBuf> {
+    if let Ok(dir) = std::env::var("RENC_PRELOAD") {
+        let mut files: Vec<PathBuf> = std::fs::read_dir(dir)
+            .expect("RENC_PRELOAD isn't a directory")
+            .map(|e| e.unwrap().path())
+            .filter(|p| p.is_file())
+            .collect();
+        files.sort();
+        return files;
+    }
+
+    let dir = std::env::temp_dir().join("renc-startup-bench");
+    std::fs::create_dir_all(&dir).unwrap();
+    (0..20)
+        .map(|m| {
+            let path = dir.join(format!("module-{}.r", m));
+            let mut source = String::new();
+            for f in 0..200 {
+                source += &format!(
+                    "m{}-f{}: func [x [integer!]] [either x > {} [x - 1] [x + {}]]\n",
+                    m, f, f, m
+                );
+            }
+            std::fs::write(&path, source).unwrap();
+            path
+        })
+        .collect()
+}
+
+/// Time the shutdown of an interpreter that has done some work, in a
+/// child process each run, since a fast shutdown can't be started again
+/// from.  Gives the mean and the best.
+#[cfg(unix)]
+fn bench_shutdown<F: Fn()>(name: &str, shutdown: F) {
+    use std::io::Read;
+    use std::os::unix::io::FromRawFd;
+
+    let mut times = Vec::new();
+    for _ in 0..RUNS {
+        let mut fds = [0; 2];
+        assert_eq!(0, unsafe { libc::pipe(fds.as_mut_ptr()) });
+        let pid = unsafe { libc::fork() };
+        if pid == 0 {
+            unsafe { rebStartup() };
+            reb_elide!("data: copy [] repeat i 100000 [append data copy {some text}]");
+            let start = Instant::now();
+            shutdown();
+            let nanos = start.elapsed().as_nanos() as u64;
+            unsafe {
+                libc::write(fds[1], nanos.to_le_bytes().as_ptr() as *const libc::c_void, 8);
+                libc::_exit(0)
+            }
+        }
+        unsafe { libc::close(fds[1]) };
+        let mut nanos = [0u8; 8];
+        unsafe { std::fs::File::from_raw_fd(fds[0]) }.read_exact(&mut nanos).unwrap();
+        unsafe { libc::waitpid(pid, std::ptr::null_mut(), 0) };
+        times.push(Duration::from_nanos(u64::from_le_bytes(nanos)));
+    }
+    let ms = |d: Duration| d.as_secs() as f64 * 1e3 + d.subsec_nanos() as f64 / 1e6;
+    let total: Duration = times.iter().sum();
+    let best = *times.iter().min().unwrap();
+    println!("{:<40} {:>8.2} ms mean {:>8.2} ms best", name, ms(total) / RUNS as f64, ms(best));
+}
+
+fn main() {
+    let scripts = preload_scripts();
+    let bundle = std::env::temp_dir().join("renc-startup-bench.bdl");
+    bundle::save(&bundle, &scripts).unwrap();
+
+    bench("rebStartup (cold)", || unsafe {
+        rebStartup();
+        rebShutdown(true);
+    });
+
+    let name = format!("rebStartup + do {} scripts", scripts.len());
+    bench(&name, || {
+        unsafe { rebStartup() };
+        for script in &scripts {
+            let path = Value::text(script.to_str().unwrap());
+            reb_elide!("do to file!", path);
+        }
+        unsafe { rebShutdown(true) };
+    });
+
+    let name = format!("rebStartupWithScripts ({} scripts)", scripts.len());
+    bench(&name, || {
+        bundle::startup(&bundle).unwrap();
+        unsafe { rebShutdown(true) };
+    });
+
+    let _ = std::fs::remove_file(&bundle);
+
+    // Between requests: a restart against a reset, after a request that
+    // leaves some garbage and definitions behind
+    let request = || {
+        reb_elide!("request-data: copy [] repeat i 1000 [append request-data i]");
+    };
+    bench("rebShutdown + rebStartup", || unsafe {
+        rebStartup();
+        request();
+        rebShutdown(true);
+    });
+    unsafe { rebStartup() };
+    checkpoint::checkpoint();
+    bench("rebResetToCheckpoint", || {
+        request();
+        checkpoint::reset();
+    });
+    unsafe { rebShutdown(true) };
+
+    #[cfg(unix)]
+    {
+        bench_shutdown("rebShutdown(true), 100K series", shutdown::clean);
+        bench_shutdown("rebShutdownFast, 100K series", shutdown::fast);
+    }
+}
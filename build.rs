@@ -12,6 +12,13 @@ fn main() {
     #[cfg(target_os = "linux")]
     println!("cargo:rustc-link-lib=r3");
 
+    // The shim's streaming codecs use the system zlib
+    #[cfg(target_os = "windows")]
+    println!("cargo:rustc-link-lib=zlib");
+
+    #[cfg(not(target_os = "windows"))]
+    println!("cargo:rustc-link-lib=z");
+
     println!("cargo:rustc-link-search=native=renc/lib");
 
     gen_binding();
@@ -44,10 +51,42 @@ fn gen_binding()
 fn build_shim()
 {
     use cc::Build;
-    Build::new()
+    let mut build = Build::new();
+    build
         .file("renc/shim/valist.c")
+        .file("renc/shim/codec.c")
+        .file("renc/shim/backend.c")
+        .file("renc/shim/instance.c")
         //.define("REBOL_EXPLICIT_END")
         .pic(true) // shared library requires this flag
-        .shared_flag(true)
-        .compile("r3shim");
+        .shared_flag(true);
+
+    // The shim's asserts (e.g. _entered calls outside of a session) cost
+    // time on every call, so only debug builds keep them.
+    if env::var("PROFILE").unwrap() == "release" {
+        build.define("NDEBUG", None);
+    }
+
+    // Backend for the rebDeflateAlloc() family (default is the core's own)
+    let libdeflate = env::var("CARGO_FEATURE_DEFLATE_LIBDEFLATE").is_ok();
+    if libdeflate {
+        build.define("SHIM_DEFLATE_LIBDEFLATE", None);
+    } else if env::var("CARGO_FEATURE_DEFLATE_ZLIB").is_ok() {
+        build.define("SHIM_DEFLATE_ZLIB", None);
+    }
+
+    // Interpreter instances, each a dlmopen()'d copy of libr3
+    let instances = env::var("CARGO_FEATURE_INSTANCES").is_ok();
+    if instances {
+        build.define("SHIM_INSTANCES", None);
+    }
+
+    build.compile("r3shim");
+
+    if libdeflate {
+        println!("cargo:rustc-link-lib=deflate");
+    }
+    if instances {
+        println!("cargo:rustc-link-lib=dl");
+    }
 }
@@ -0,0 +1,315 @@
+//
+// Deflate backends for the rebDeflateAlloc() family (see %backend.h)
+//
+// SHIM_DEFLATE_ZLIB runs them on the shim's codecs over the zlib linked
+// with the shim (which may be zlib-ng's drop-in build), reusing one codec
+// per format instead of setting up zlib's state on every call.
+// SHIM_DEFLATE_LIBDEFLATE runs them on libdeflate, which is much faster
+// for whole-buffer work but can't stream.  Both give the same formats
+// as the core.
+//
+// Decompression is also what rebDecompressAlloc() and
+// rebDeflateDetectAlloc() run on, whatever the backend; with the core's,
+// that uses the shim's codecs.
+//
+// The cached contexts are per interpreter, in its SHIM_STATE, made on
+// first use and freed by Backend_Free() when it shuts down.  Calls into
+// one interpreter are made one at a time, so they aren't locked.
+//
+
+#define REBOL_DISABLE_ACCESSOR_MACROS
+#include <assert.h>
+#include <errno.h>  // ENOMEM
+#include <stdlib.h>  // calloc(), free()
+#include "../include/rebol.h"
+
+#include "codec.h"
+#include "backend.h"
+#include "dispatch.h"
+
+#if defined(SHIM_DEFLATE_LIBDEFLATE)
+    const char *Backend_Name = "libdeflate";
+#elif defined(SHIM_DEFLATE_ZLIB)
+    const char *Backend_Name = "zlib";
+#else
+    const char *Backend_Name = "core";
+#endif
+
+#if defined(SHIM_DEFLATE_LIBDEFLATE)
+    #include <libdeflate.h>
+#endif
+
+ATTRIBUTE_NO_RETURN
+static void Fail_Internal(const void *p, ...) {
+    va_list va; va_start(va, p);
+    RL_rebJumps(0, p, &va);
+    DEAD_END;
+}
+
+// Envelope of compressed data: gzip by its magic number, zlib by its
+// header check (a multiple of 31, with the DEFLATE method), else raw.
+//
+static int Detect_Format(const unsigned char *in, size_t len) {
+    if (len >= 2 && in[0] == 0x1f && in[1] == 0x8b)
+        return REB_CODEC_GZIP;
+    if (
+        len >= 2 && (in[0] & 0x0f) == 8 && (in[0] >> 4) <= 7
+        && ((in[0] << 8) | in[1]) % 31 == 0
+    ){
+        return REB_CODEC_ZLIB;
+    }
+    return REB_CODEC_DEFLATE;
+}
+
+// A caller's *format of -1 is detected; anything else must be a format.
+//
+static int Resolve_Format(int *format, const unsigned char *in, size_t len) {
+    if (*format == -1)
+        *format = Detect_Format(in, len);
+    else if (*format < REB_CODEC_DEFLATE || *format > REB_CODEC_GZIP)
+        Fail_Internal("fail {Unknown compression format}", rebEND);
+    return *format;
+}
+
+// First guess at the decompressed size.  If it's right, the output is
+// allocated once, with no growing or shrinking.  A caller's hint is
+// taken as given.  A gzip trailer records the size (mod 2^32), but that's
+// only believed if DEFLATE could actually expand the input that much
+// (about 1032:1), so bad data can't force a huge buffer.
+//
+static size_t Guess_Size(
+    const unsigned char *in, size_t len, int max, int format, size_t hint
+){
+    size_t guess = len < 16 ? 64 : len * 4;
+    if (hint != 0)
+        guess = hint;
+    else if (format == REB_CODEC_GZIP && len >= 18) {
+        const unsigned char *t = in + len - 4;
+        size_t isize = t[0] | (t[1] << 8) | (t[2] << 16) | ((size_t)t[3] << 24);
+        if (isize / 1032 <= len)
+            guess = isize == 0 ? 1 : isize;
+    }
+    if (max >= 0 && guess > (size_t)max)
+        guess = max == 0 ? 1 : (size_t)max;
+    return guess;
+}
+
+// Next size for a decompression buffer that came up short.
+//
+static size_t Grow_Size(size_t cap, int max) {
+    if (max >= 0 && cap >= (size_t)max)
+        Fail_Internal("fail {Decompressed data is bigger than max}", rebEND);
+    cap *= 2;
+    if (max >= 0 && cap > (size_t)max)
+        cap = (size_t)max;
+    return cap;
+}
+
+static void *Shrink(void *out, size_t size, size_t cap) {
+    if (size == cap)
+        return out;
+    return RL_rebRealloc(out, size == 0 ? 1 : size);
+}
+
+// The entered interpreter's cached contexts (see the top of the file).
+//
+#if defined(SHIM_DEFLATE_LIBDEFLATE)
+    struct shim_backend {
+        struct libdeflate_compressor *compressor;
+        struct libdeflate_decompressor *decompressor;
+    };
+#else
+    struct shim_backend {
+        REBCDC *decompressors[3];  // by REB_CODEC_XXX
+        REBCDC *compressors[3];  // only with SHIM_DEFLATE_BACKEND
+    };
+#endif
+
+static struct shim_backend *Backend(void) {
+    struct shim_backend **backend = &Shim_State->backend;
+    if (*backend == NULL) {
+        *backend = (struct shim_backend*)calloc(1, sizeof(struct shim_backend));
+        if (*backend == NULL)
+            RL_rebFail_OS(ENOMEM);
+    }
+    return *backend;
+}
+
+#if defined(SHIM_DEFLATE_LIBDEFLATE)
+
+void Backend_Free(struct shim_backend *backend) {
+    if (backend == NULL)
+        return;
+    if (backend->compressor)
+        libdeflate_free_compressor(backend->compressor);
+    if (backend->decompressor)
+        libdeflate_free_decompressor(backend->decompressor);
+    free(backend);
+}
+
+void *Backend_Compress_Alloc(
+    size_t *out_len, const void *input, size_t in_len, int format
+){
+    struct shim_backend *backend = Backend();
+    if (backend->compressor == NULL)
+        backend->compressor = libdeflate_alloc_compressor(6);
+    if (backend->compressor == NULL)
+        RL_rebFail_OS(ENOMEM);
+    struct libdeflate_compressor *compressor = backend->compressor;
+
+    size_t cap;
+    switch (format) {
+      case REB_CODEC_ZLIB:
+        cap = libdeflate_zlib_compress_bound(compressor, in_len); break;
+      case REB_CODEC_GZIP:
+        cap = libdeflate_gzip_compress_bound(compressor, in_len); break;
+      default:
+        cap = libdeflate_deflate_compress_bound(compressor, in_len); break;
+    }
+
+    void *out = RL_rebMalloc(cap);
+    size_t size;
+    switch (format) {
+      case REB_CODEC_ZLIB:
+        size = libdeflate_zlib_compress(compressor, input, in_len, out, cap);
+        break;
+      case REB_CODEC_GZIP:
+        size = libdeflate_gzip_compress(compressor, input, in_len, out, cap);
+        break;
+      default:
+        size = libdeflate_deflate_compress(compressor, input, in_len, out, cap);
+        break;
+    }
+    assert(size != 0);  // the bound always fits
+
+    *out_len = size;
+    return Shrink(out, size, cap);
+}
+
+void *Backend_Decompress_Alloc(
+    size_t *out_len, const void *input, size_t in_len,
+    int max, int *format, size_t hint
+){
+    struct shim_backend *backend = Backend();
+    if (backend->decompressor == NULL)
+        backend->decompressor = libdeflate_alloc_decompressor();
+    if (backend->decompressor == NULL)
+        RL_rebFail_OS(ENOMEM);
+    struct libdeflate_decompressor *decompressor = backend->decompressor;
+
+    const unsigned char *in = (const unsigned char*)input;
+    Resolve_Format(format, in, in_len);
+
+    size_t cap = Guess_Size(in, in_len, max, *format, hint);
+    void *out = RL_rebMalloc(cap);
+    size_t size;
+    for (;;) {
+        enum libdeflate_result result;
+        switch (*format) {
+          case REB_CODEC_ZLIB:
+            result = libdeflate_zlib_decompress(
+                decompressor, in, in_len, out, cap, &size
+            );
+            break;
+          case REB_CODEC_GZIP:
+            result = libdeflate_gzip_decompress(
+                decompressor, in, in_len, out, cap, &size
+            );
+            break;
+          default:
+            result = libdeflate_deflate_decompress(
+                decompressor, in, in_len, out, cap, &size
+            );
+            break;
+        }
+        if (result == LIBDEFLATE_SUCCESS)
+            break;
+        if (result != LIBDEFLATE_INSUFFICIENT_SPACE)
+            Fail_Internal("fail {Compressed data is corrupt}", rebEND);
+
+        cap = Grow_Size(cap, max);  // libdeflate has to start over
+        out = RL_rebRealloc(out, cap);
+    }
+
+    *out_len = size;
+    return Shrink(out, size, cap);
+}
+
+#else  // shim codecs
+
+void Backend_Free(struct shim_backend *backend) {
+    if (backend == NULL)
+        return;
+    int i;
+    for (i = 0; i < 3; ++i) {
+        if (backend->decompressors[i])
+            rebCloseCodec(backend->decompressors[i]);
+        if (backend->compressors[i])
+            rebCloseCodec(backend->compressors[i]);
+    }
+    free(backend);
+}
+
+#if defined(SHIM_DEFLATE_BACKEND)
+
+void *Backend_Compress_Alloc(
+    size_t *out_len, const void *input, size_t in_len, int format
+){
+    REBCDC **codec = &Backend()->compressors[format];
+    if (*codec == NULL && !(*codec = rebOpenCompressor(format, -1)))
+        RL_rebFail_OS(ENOMEM);
+
+    size_t cap = rebCompressBound(*codec, in_len);
+    void *out = RL_rebMalloc(cap);
+    size_t size = cap;
+    int status = rebCompressInto(*codec, out, &size, input, in_len);
+    assert(status == REB_CODEC_DONE);  // the bound always fits
+    (void)status;
+
+    *out_len = size;
+    return Shrink(out, size, cap);
+}
+
+#endif
+
+void *Backend_Decompress_Alloc(
+    size_t *out_len, const void *input, size_t in_len,
+    int max, int *format, size_t hint
+){
+    const unsigned char *in = (const unsigned char*)input;
+    Resolve_Format(format, in, in_len);
+
+    REBCDC **codec = &Backend()->decompressors[*format];
+    if (*codec == NULL && !(*codec = rebOpenDecompressor(*format)))
+        RL_rebFail_OS(ENOMEM);
+    rebCodecReset(*codec);
+
+    size_t cap = Guess_Size(in, in_len, max, *format, hint);
+    unsigned char *out = (unsigned char*)RL_rebMalloc(cap);
+    size_t used = 0;
+    for (;;) {
+        size_t in_n = in_len;
+        size_t out_n = cap - used;
+        int status = rebCodecStep(
+            *codec, in, &in_n, out + used, &out_n, REB_CODEC_NO_FLUSH
+        );
+        in += in_n;
+        in_len -= in_n;
+        used += out_n;
+
+        if (status == REB_CODEC_DONE)
+            break;
+        if (status == REB_CODEC_ERROR)
+            Fail_Internal("fail {Compressed data is corrupt}", rebEND);
+        if (used < cap)  // had room, so it ran out of input
+            Fail_Internal("fail {Compressed data is truncated}", rebEND);
+
+        cap = Grow_Size(cap, max);
+        out = (unsigned char*)RL_rebRealloc(out, cap);
+    }
+
+    *out_len = used;
+    return Shrink(out, used, cap);
+}
+
+#endif
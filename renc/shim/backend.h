@@ -0,0 +1,42 @@
+/*
+ * Private to the shim: the deflate backend in %backend.c, which the
+ * rebDeflateAlloc() family in %valist.c is routed to when one is chosen
+ * at build time (see the cargo features in %Cargo.toml).  Without one
+ * those calls go to the core's built-in zlib.  rebDecompressAlloc()
+ * and rebDeflateDetectAlloc() always run here.
+ */
+#ifndef REBOL_SHIM_BACKEND_H
+#define REBOL_SHIM_BACKEND_H
+
+#if defined(SHIM_DEFLATE_ZLIB) || defined(SHIM_DEFLATE_LIBDEFLATE)
+    #define SHIM_DEFLATE_BACKEND
+
+    /*
+     * Same contract as the core's: the result is rebMalloc()'d.
+     */
+    void *Backend_Compress_Alloc(
+        size_t *out_len, const void *input, size_t in_len, int format
+    );
+#endif
+
+/*
+ * Decompression is there whatever the backend, for rebDecompressAlloc()
+ * and rebDeflateDetectAlloc().  Same contract as the core's: the result
+ * is rebMalloc()'d, and bad data (or output over `max`, when it's not -1)
+ * fails.  A `*format` of -1 is detected (and updated); any other that
+ * isn't a REB_CODEC_XXX fails.  A nonzero `hint` is the expected size.
+ */
+void *Backend_Decompress_Alloc(
+    size_t *out_len, const void *input, size_t in_len,
+    int max, int *format, size_t hint
+);
+
+/*
+ * Free an interpreter's cached contexts (see SHIM_STATE); NULL is none.
+ */
+struct shim_backend;
+void Backend_Free(struct shim_backend *backend);
+
+extern const char *Backend_Name;
+
+#endif
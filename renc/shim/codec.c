@@ -0,0 +1,298 @@
+//
+// Streaming codecs (see %codec.h), over zlib.
+//
+// zlib counts in `uInt`, so a step bigger than that is fed to it in
+// pieces.  The flush is only passed along with the last piece of input,
+// since zlib doesn't allow new input after Z_FINISH.
+//
+
+#ifdef WIN32
+#define RL_API __dllspec(dllexport)
+#else
+#define RL_API
+#endif
+
+#include <assert.h>
+#include <limits.h>  // UINT_MAX
+#include <stdlib.h>  // malloc(), free()
+#include <string.h>  // memcpy()
+#include <zlib.h>
+
+#include "codec.h"
+
+struct rebol_codec {
+    z_stream strm;
+    int compress;  // deflate (vs. inflate)
+    int format;
+    const REBCDD *dict;
+    const char *error;
+};
+
+struct rebol_codec_dictionary {
+    uInt size;
+    Bytef data[1];  // actually `size` bytes
+};
+
+static int Window_Bits(int format) {
+    switch (format) {
+      case REB_CODEC_DEFLATE: return -MAX_WBITS;
+      case REB_CODEC_ZLIB: return MAX_WBITS;
+      case REB_CODEC_GZIP: return MAX_WBITS + 16;
+      default: return 0;
+    }
+}
+
+RL_API REBCDC * rebOpenCompressor(int format, int level) {
+    int bits = Window_Bits(format);
+    if (bits == 0 || level < -1 || level > 9)
+        return NULL;
+
+    REBCDC *codec = (REBCDC*)calloc(1, sizeof(REBCDC));
+    if (codec == NULL)
+        return NULL;
+    codec->compress = 1;
+    codec->format = format;
+
+    int ret = deflateInit2(
+        &codec->strm, level, Z_DEFLATED, bits, 8, Z_DEFAULT_STRATEGY
+    );
+    if (ret != Z_OK) {
+        free(codec);
+        return NULL;
+    }
+    return codec;
+}
+
+RL_API REBCDC * rebOpenDecompressor(int format) {
+    int bits = Window_Bits(format);
+    if (bits == 0)
+        return NULL;
+
+    REBCDC *codec = (REBCDC*)calloc(1, sizeof(REBCDC));
+    if (codec == NULL)
+        return NULL;
+
+    codec->format = format;
+
+    if (inflateInit2(&codec->strm, bits) != Z_OK) {
+        free(codec);
+        return NULL;
+    }
+    return codec;
+}
+
+RL_API int rebCodecStep(
+    REBCDC * codec,
+    const void * in, size_t * in_len,
+    void * out, size_t * out_len,
+    int flush
+){
+    z_stream *strm = &codec->strm;
+    size_t in_left = *in_len;
+    size_t out_left = *out_len;
+    int status = REB_CODEC_OK;
+
+    int zflush;
+    switch (flush) {
+      case REB_CODEC_SYNC_FLUSH: zflush = Z_SYNC_FLUSH; break;
+      case REB_CODEC_FINISH: zflush = Z_FINISH; break;
+      default: zflush = Z_NO_FLUSH; break;
+    }
+
+    strm->next_in = (Bytef*)in;
+    strm->next_out = (Bytef*)out;
+
+    for (;;) {
+        uInt avail_in = in_left > UINT_MAX ? UINT_MAX : (uInt)in_left;
+        uInt avail_out = out_left > UINT_MAX ? UINT_MAX : (uInt)out_left;
+        strm->avail_in = avail_in;
+        strm->avail_out = avail_out;
+
+        int ret;
+        if (codec->compress)
+            ret = deflate(strm, avail_in == in_left ? zflush : Z_NO_FLUSH);
+        else
+            ret = inflate(strm, Z_NO_FLUSH);
+
+        in_left -= avail_in - strm->avail_in;
+        out_left -= avail_out - strm->avail_out;
+
+        if (ret == Z_STREAM_END) {
+            status = REB_CODEC_DONE;
+            break;
+        }
+        if (ret == Z_BUF_ERROR)  // no progress possible, not an error
+            break;
+        if (ret == Z_NEED_DICT && codec->dict) {  // zlib format asks for it
+            ret = inflateSetDictionary(
+                strm, codec->dict->data, codec->dict->size
+            );
+            if (ret == Z_OK)
+                continue;
+            codec->error = "compressed data needs a different dictionary";
+            status = REB_CODEC_ERROR;
+            break;
+        }
+        if (ret != Z_OK) {
+            if (ret == Z_NEED_DICT)
+                codec->error = "compressed data needs a dictionary";
+            else
+                codec->error = strm->msg ? strm->msg : "corrupt stream";
+            status = REB_CODEC_ERROR;
+            break;
+        }
+        if (out_left == 0)
+            break;
+        if (in_left == 0 && strm->avail_out != 0)
+            break;  // took all the input and had room for all the output
+    }
+
+    *in_len -= in_left;
+    *out_len -= out_left;
+    return status;
+}
+
+RL_API const char * rebCodecError(const REBCDC * codec) {
+    return codec->error ? codec->error : "no error";
+}
+
+// A compressor's dictionary goes in at the start of each stream.  So does
+// a raw DEFLATE decompressor's; a zlib stream names its dictionary in its
+// header, and asks for it (Z_NEED_DICT) when inflate() gets there.
+//
+static void Apply_Dictionary(REBCDC * codec) {
+    if (codec->dict == NULL)
+        return;
+    if (codec->compress)
+        deflateSetDictionary(
+            &codec->strm, codec->dict->data, codec->dict->size
+        );
+    else if (codec->format == REB_CODEC_DEFLATE)
+        inflateSetDictionary(
+            &codec->strm, codec->dict->data, codec->dict->size
+        );
+}
+
+RL_API void rebCodecReset(REBCDC * codec) {
+    if (codec->compress)
+        deflateReset(&codec->strm);
+    else
+        inflateReset(&codec->strm);
+    Apply_Dictionary(codec);
+    codec->error = NULL;
+}
+
+RL_API int rebCodecParams(REBCDC * codec, int level, int strategy) {
+    if (
+        !codec->compress
+        || level < -1 || level > 9
+        || strategy < REB_CODEC_DEFAULT_STRATEGY || strategy > REB_CODEC_FIXED
+    ){
+        codec->error = "bad compression level or strategy";
+        return REB_CODEC_ERROR;
+    }
+    deflateReset(&codec->strm);
+    codec->error = NULL;
+    if (deflateParams(&codec->strm, level, strategy) != Z_OK) {
+        codec->error = "couldn't change compression parameters";
+        return REB_CODEC_ERROR;
+    }
+    Apply_Dictionary(codec);
+    return REB_CODEC_OK;
+}
+
+RL_API REBCDD * rebOpenDictionary(const void * data, size_t size) {
+    if (size > 32768) {  // only the window's worth at the tail can matter
+        data = (const Bytef*)data + (size - 32768);
+        size = 32768;
+    }
+    REBCDD *dict = (REBCDD*)malloc(sizeof(REBCDD) + size);
+    if (dict == NULL)
+        return NULL;
+    dict->size = (uInt)size;
+    memcpy(dict->data, data, size);
+    return dict;
+}
+
+RL_API void rebCloseDictionary(REBCDD * dict) {
+    free(dict);
+}
+
+RL_API int rebCodecDictionary(REBCDC * codec, const REBCDD * dict) {
+    if (dict && codec->format == REB_CODEC_GZIP) {
+        codec->error = "gzip streams can't use a preset dictionary";
+        return REB_CODEC_ERROR;
+    }
+    codec->dict = dict;
+    rebCodecReset(codec);
+    return REB_CODEC_OK;
+}
+
+RL_API size_t rebCompressBound(const REBCDC * codec, size_t in_len) {
+    assert(codec->compress);
+    return deflateBound((z_streamp)&codec->strm, (uLong)in_len);
+}
+
+static int Step_Into(
+    REBCDC * codec,
+    void * out, size_t * out_len,
+    const void * in, size_t in_len
+){
+    rebCodecReset(codec);
+
+    size_t room = *out_len;
+    int status = rebCodecStep(
+        codec, in, &in_len, out, out_len, REB_CODEC_FINISH
+    );
+    if (status == REB_CODEC_OK) {  // stopped short of the end
+        if (*out_len == room)
+            codec->error = "output buffer too small";
+        else
+            codec->error = "compressed data is truncated";
+        status = REB_CODEC_ERROR;
+    }
+    return status;
+}
+
+RL_API int rebCompressInto(
+    REBCDC * codec,
+    void * out, size_t * out_len,
+    const void * in, size_t in_len
+){
+    assert(codec->compress);
+    return Step_Into(codec, out, out_len, in, in_len);
+}
+
+RL_API int rebDecompressInto(
+    REBCDC * codec,
+    void * out, size_t * out_len,
+    const void * in, size_t in_len
+){
+    assert(!codec->compress);
+    return Step_Into(codec, out, out_len, in, in_len);
+}
+
+RL_API void rebCloseCodec(REBCDC * codec) {
+    if (codec == NULL)
+        return;
+    if (codec->compress)
+        deflateEnd(&codec->strm);
+    else
+        inflateEnd(&codec->strm);
+    free(codec);
+}
+
+RL_API unsigned long rebCrc32(unsigned long crc, const void * data, size_t size) {
+    const Bytef *bytes = (const Bytef*)data;
+    do {  // once even if empty, so (0, NULL, 0) gives the initial value
+        uInt piece = size > UINT_MAX ? UINT_MAX : (uInt)size;
+        crc = crc32(crc, bytes, piece);
+        bytes += piece;
+        size -= piece;
+    } while (size != 0);
+    return crc;
+}
+
+RL_API unsigned long rebCrc32Combine(unsigned long crc1, unsigned long crc2, size_t size2) {
+    return crc32_combine(crc1, crc2, (z_off_t)size2);
+}
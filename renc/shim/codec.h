@@ -0,0 +1,153 @@
+/*
+ * Prototypes for the streaming codecs in %codec.c
+ *
+ * The core's rebDeflateAlloc() and friends take the whole input and give
+ * back the whole output, so both have to fit in memory at once.  These
+ * codecs take input and produce output a chunk at a time instead, so a
+ * stream of any length can be (de)compressed in bounded memory.
+ *
+ * A codec doesn't touch the interpreter: it may be used before
+ * rebStartup(), and from any thread (one thread per codec at a time).
+ */
+#ifndef REBOL_SHIM_CODEC_H
+#define REBOL_SHIM_CODEC_H
+
+#include <stddef.h>  // size_t
+
+#if !defined(RL_API)
+    #define RL_API
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct rebol_codec REBCDC;
+
+/*
+ * Framing of the compressed data, as with the core's rebDeflateAlloc()
+ * (raw DEFLATE), rebZdeflateAlloc() (zlib envelope) and rebGzipAlloc().
+ */
+#define REB_CODEC_DEFLATE 0
+#define REB_CODEC_ZLIB 1
+#define REB_CODEC_GZIP 2
+
+#define REB_CODEC_NO_FLUSH 0  /* buffer as much as the codec likes */
+#define REB_CODEC_SYNC_FLUSH 1  /* emit everything fed so far */
+#define REB_CODEC_FINISH 2  /* no more input; emit the stream's tail */
+
+/*
+ * Compression strategies (see zlib's deflateInit2()).  FILTERED and RLE
+ * suit data like images or sensor samples; HUFFMAN_ONLY is the fastest.
+ */
+#define REB_CODEC_DEFAULT_STRATEGY 0
+#define REB_CODEC_FILTERED 1
+#define REB_CODEC_HUFFMAN_ONLY 2
+#define REB_CODEC_RLE 3
+#define REB_CODEC_FIXED 4
+
+/*
+ * Results of rebCodecStep()
+ */
+#define REB_CODEC_ERROR -1  /* see rebCodecError() */
+#define REB_CODEC_OK 0  /* call again with more input or output room */
+#define REB_CODEC_DONE 1  /* end of the stream was produced (or read) */
+
+/*
+ * `level` is 0 (store) to 9 (smallest), or -1 for the default.  These
+ * return NULL if out of memory or given a bad format or level.
+ */
+RL_API REBCDC * rebOpenCompressor(int format, int level);
+RL_API REBCDC * rebOpenDecompressor(int format);
+
+/*
+ * Move data through the codec.  On input `*in_len` is the size of `in`
+ * and `*out_len` the room in `out`; on return they are how much was
+ * consumed and produced.  A decompressor ignores `flush`.
+ *
+ * A compressor given REB_CODEC_FINISH returns REB_CODEC_OK until it has
+ * produced all of its output, and must be called again (with the same
+ * flush and no new input) until it returns REB_CODEC_DONE.
+ */
+RL_API int rebCodecStep(
+    REBCDC * codec,
+    const void * in, size_t * in_len,
+    void * out, size_t * out_len,
+    int flush
+);
+
+/*
+ * Message for the last REB_CODEC_ERROR (never NULL).
+ */
+RL_API const char * rebCodecError(const REBCDC * codec);
+
+/*
+ * Start a new stream with the same settings, reusing the codec's memory.
+ */
+RL_API void rebCodecReset(REBCDC * codec);
+
+/*
+ * Reset a compressor, with a new level and strategy.
+ */
+RL_API int rebCodecParams(REBCDC * codec, int level, int strategy);
+
+/*
+ * One-shot (de)compression into a caller's buffer, reusing the codec so
+ * that nothing is allocated.  The codec is reset first.  On input
+ * `*out_len` is the room in `out`, on return the size of the result.
+ * Returns REB_CODEC_DONE, or REB_CODEC_ERROR if the result doesn't fit
+ * (or the input is corrupt or truncated).
+ *
+ * rebCompressBound() is the most a compressor with its current settings
+ * can produce for `in_len` bytes, so an `out` that big always fits.
+ */
+RL_API size_t rebCompressBound(const REBCDC * codec, size_t in_len);
+RL_API int rebCompressInto(
+    REBCDC * codec,
+    void * out, size_t * out_len,
+    const void * in, size_t in_len
+);
+RL_API int rebDecompressInto(
+    REBCDC * codec,
+    void * out, size_t * out_len,
+    const void * in, size_t in_len
+);
+
+RL_API void rebCloseCodec(REBCDC * codec);
+
+/*
+ * PRESET DICTIONARIES
+ *
+ * Tiny messages compress poorly because each stream starts with no
+ * history.  A dictionary of typical content (e.g. concatenated sample
+ * messages, most common strings last) primes it.  Both ends must use
+ * the same one; zlib-format streams record which (by checksum) in their
+ * header and fail to decompress with any other.  gzip has no way to
+ * carry one.
+ *
+ * rebOpenDictionary() copies the data (only the last 32K matters), and
+ * the result is immutable, so any number of codecs on any threads can
+ * share it.  It must outlive the codecs using it.
+ *
+ * rebCodecDictionary() resets the codec, and uses `dict` (or none, if
+ * NULL) for each stream from then on.
+ */
+typedef struct rebol_codec_dictionary REBCDD;
+
+RL_API REBCDD * rebOpenDictionary(const void * data, size_t size);
+RL_API void rebCloseDictionary(REBCDD * dict);
+RL_API int rebCodecDictionary(REBCDC * codec, const REBCDD * dict);
+
+/*
+ * CRC-32 as used by gzip: rebCrc32(0, NULL, 0) gives the initial value,
+ * and rebCrc32Combine() gives the CRC of two pieces concatenated from
+ * the CRCs of each and the size of the second.
+ */
+RL_API unsigned long rebCrc32(unsigned long crc, const void * data, size_t size);
+RL_API unsigned long rebCrc32Combine(unsigned long crc1, unsigned long crc2, size_t size2);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,162 @@
+/*
+ * Private to the shim: where its calls into the core go, and what it
+ * keeps for each interpreter.
+ *
+ * Normally that's straight to the libr3 the program is linked with.  With
+ * SHIM_INSTANCES (the `instances` cargo feature), each RL_rebXxx() call in
+ * the shim instead goes through the RL_LIB table of the interpreter
+ * instance entered on the calling thread (see rebCreateInstance() in
+ * %valist.h), which is the linked libr3 until one is entered.  That costs
+ * a thread-local load and an indirect call per call into the core.
+ *
+ * Include after %rebol.h, since its prototypes name the RL_rebXxx()s.
+ * %instance.c, which fills the tables, defines SHIM_NO_DISPATCH.
+ */
+#ifndef REBOL_SHIM_DISPATCH_H
+#define REBOL_SHIM_DISPATCH_H
+
+#if defined(_MSC_VER)
+    #define SHIM_THREAD_LOCAL __declspec(thread)
+#else
+    #define SHIM_THREAD_LOCAL __thread
+#endif
+
+/*
+ * For state the GC can reach from another thread: it runs handle cleaners
+ * on whichever thread it happens to run on.
+ */
+#if defined(_WIN32)
+    #define WIN32_LEAN_AND_MEAN
+    #include <windows.h>
+    typedef SRWLOCK SHIM_LOCK;
+    #define SHIM_LOCK_INIT SRWLOCK_INIT
+    #define Shim_Lock(l) AcquireSRWLockExclusive(l)
+    #define Shim_Unlock(l) ReleaseSRWLockExclusive(l)
+    #define Shim_Lock_Init(l) InitializeSRWLock(l)
+    #define Shim_Lock_Free(l) ((void)(l))
+#else
+    #include <pthread.h>
+    typedef pthread_mutex_t SHIM_LOCK;
+    #define SHIM_LOCK_INIT PTHREAD_MUTEX_INITIALIZER
+    #define Shim_Lock(l) pthread_mutex_lock(l)
+    #define Shim_Unlock(l) pthread_mutex_unlock(l)
+    #define Shim_Lock_Init(l) pthread_mutex_init((l), NULL)
+    #define Shim_Lock_Free(l) pthread_mutex_destroy(l)
+#endif
+
+/*
+ * What the shim keeps for an interpreter, but that isn't held by it: its
+ * table of foreign handle owners, series pinned by views, checkpoint and
+ * cached codecs, and with instances, its handle arenas.  There's one for the linked libr3 and one
+ * in each REBINST, and Shim_State is the one for the interpreter entered
+ * on the calling thread.  The linked interpreter's arenas are per thread
+ * instead, as any thread may call into it (one at a time), while an
+ * instance is only used on the thread that made it.
+ */
+typedef struct {
+    unsigned int depth;
+    const REBVAL **handles;
+    size_t count;
+    size_t capacity;
+    size_t *index;  // 1 + position, or 0
+    size_t index_mask;  // size - 1
+} SHIM_ARENA;
+
+typedef struct shim_owner SHIM_OWNER;  // %valist.c
+typedef struct shim_pin SHIM_PIN;  // %valist.c
+struct shim_backend;  // %backend.c
+
+typedef struct {
+    SHIM_ARENA arena;  // instances only, see above
+    SHIM_LOCK owners_lock;
+    SHIM_OWNER **owners;  // set of live records, see %valist.c
+    size_t owners_count;
+    size_t owners_mask;  // size - 1
+    bool handle_layout_checked;
+    SHIM_PIN *pins;
+    size_t pins_count;
+    size_t pins_capacity;
+    REBVAL *checkpoint;
+    struct shim_backend *backend;
+} SHIM_STATE;
+
+#if defined(SHIM_INSTANCES)
+    typedef struct {
+        RL_LIB lib;  // first, so Shim_Current points at the whole
+        SHIM_STATE state;
+    } SHIM_INTERPRETER;
+
+    extern SHIM_INTERPRETER Shim_Linked;
+    extern SHIM_THREAD_LOCAL RL_LIB *Shim_Current;
+    #define Shim_State (&((SHIM_INTERPRETER*)Shim_Current)->state)
+#else
+    extern SHIM_STATE Shim_Linked_State;
+    #define Shim_State (&Shim_Linked_State)
+#endif
+
+#if defined(SHIM_INSTANCES) && !defined(SHIM_NO_DISPATCH)
+    #define RL_rebEnterApi_internal Shim_Current->rebEnterApi_internal
+    #define RL_rebMalloc Shim_Current->rebMalloc
+    #define RL_rebRealloc Shim_Current->rebRealloc
+    #define RL_rebFree Shim_Current->rebFree
+    #define RL_rebRepossess Shim_Current->rebRepossess
+    #define RL_rebStartup Shim_Current->rebStartup
+    #define RL_rebShutdown Shim_Current->rebShutdown
+    #define RL_rebTick Shim_Current->rebTick
+    #define RL_rebVoid Shim_Current->rebVoid
+    #define RL_rebBlank Shim_Current->rebBlank
+    #define RL_rebLogic Shim_Current->rebLogic
+    #define RL_rebChar Shim_Current->rebChar
+    #define RL_rebInteger Shim_Current->rebInteger
+    #define RL_rebDecimal Shim_Current->rebDecimal
+    #define RL_rebSizedBinary Shim_Current->rebSizedBinary
+    #define RL_rebUninitializedBinary_internal \
+        Shim_Current->rebUninitializedBinary_internal
+    #define RL_rebBinaryHead_internal Shim_Current->rebBinaryHead_internal
+    #define RL_rebBinaryAt_internal Shim_Current->rebBinaryAt_internal
+    #define RL_rebBinarySizeAt_internal Shim_Current->rebBinarySizeAt_internal
+    #define RL_rebSizedText Shim_Current->rebSizedText
+    #define RL_rebText Shim_Current->rebText
+    #define RL_rebLengthedTextWide Shim_Current->rebLengthedTextWide
+    #define RL_rebTextWide Shim_Current->rebTextWide
+    #define RL_rebHandle Shim_Current->rebHandle
+    #define RL_rebArgR Shim_Current->rebArgR
+    #define RL_rebArg Shim_Current->rebArg
+    #define RL_rebValue Shim_Current->rebValue
+    #define RL_rebQuote Shim_Current->rebQuote
+    #define RL_rebElide Shim_Current->rebElide
+    #define RL_rebJumps Shim_Current->rebJumps
+    #define RL_rebDid Shim_Current->rebDid
+    #define RL_rebNot Shim_Current->rebNot
+    #define RL_rebUnbox Shim_Current->rebUnbox
+    #define RL_rebUnbox0 Shim_Current->rebUnbox0
+    #define RL_rebUnboxInteger Shim_Current->rebUnboxInteger
+    #define RL_rebUnboxInteger0 Shim_Current->rebUnboxInteger0
+    #define RL_rebUnboxDecimal Shim_Current->rebUnboxDecimal
+    #define RL_rebUnboxChar Shim_Current->rebUnboxChar
+    #define RL_rebSpellInto Shim_Current->rebSpellInto
+    #define RL_rebSpell Shim_Current->rebSpell
+    #define RL_rebSpellIntoWide Shim_Current->rebSpellIntoWide
+    #define RL_rebSpellWide Shim_Current->rebSpellWide
+    #define RL_rebBytesInto Shim_Current->rebBytesInto
+    #define RL_rebBytes Shim_Current->rebBytes
+    #define RL_rebRescue Shim_Current->rebRescue
+    #define RL_rebRescueWith Shim_Current->rebRescueWith
+    #define RL_rebHalt Shim_Current->rebHalt
+    #define RL_rebQUOTING Shim_Current->rebQUOTING
+    #define RL_rebUNQUOTING Shim_Current->rebUNQUOTING
+    #define RL_rebRELEASING Shim_Current->rebRELEASING
+    #define RL_rebManage Shim_Current->rebManage
+    #define RL_rebUnmanage Shim_Current->rebUnmanage
+    #define RL_rebRelease Shim_Current->rebRelease
+    #define RL_rebDeflateAlloc Shim_Current->rebDeflateAlloc
+    #define RL_rebZdeflateAlloc Shim_Current->rebZdeflateAlloc
+    #define RL_rebGzipAlloc Shim_Current->rebGzipAlloc
+    #define RL_rebInflateAlloc Shim_Current->rebInflateAlloc
+    #define RL_rebZinflateAlloc Shim_Current->rebZinflateAlloc
+    #define RL_rebGunzipAlloc Shim_Current->rebGunzipAlloc
+    #define RL_rebDeflateDetectAlloc Shim_Current->rebDeflateDetectAlloc
+    #define RL_rebFail_OS Shim_Current->rebFail_OS
+#endif
+
+#endif
@@ -0,0 +1,162 @@
+//
+// Interpreter instances (see rebCreateInstance() in %valist.h)
+//
+// The core's RL_LIB table is how an extension DLL calls into the EXE that
+// loaded it.  Here one is filled in for each loaded copy of libr3, from
+// dlsym()s of its RL_rebXxx() exports, plus one for the linked libr3; the
+// rest of the shim calls through the one entered on its thread (see
+// %dispatch.h).
+//
+// dlmopen() with LM_ID_NEWLM loads the library and its dependencies into
+// a new link namespace, so each copy gets its own globals: its own heap,
+// GC, symbol table and system contexts.
+//
+
+#if defined(SHIM_INSTANCES)
+    #define _GNU_SOURCE  // dlmopen()
+    #include <dlfcn.h>
+#endif
+
+#define REBOL_DISABLE_ACCESSOR_MACROS
+#include <stdio.h>  // snprintf()
+#include <stdlib.h>  // calloc(), free()
+#include "../include/rebol.h"
+
+#ifdef WIN32
+#define RL_API __dllspec(dllexport)
+#else
+#define RL_API
+#endif
+
+#define SHIM_NO_DISPATCH  // this file names the linked entry points
+#include "valist.h"
+#include "dispatch.h"
+
+static SHIM_THREAD_LOCAL char Instance_Error[256] = "no error";
+
+#if defined(SHIM_INSTANCES)
+
+// Every entry of RL_LIB, in order.
+//
+#define SHIM_RL_ENTRIES(X) \
+    X(rebEnterApi_internal) X(rebMalloc) X(rebRealloc) X(rebFree) \
+    X(rebRepossess) X(rebStartup) X(rebShutdown) X(rebTick) \
+    X(rebVoid) X(rebBlank) X(rebLogic) X(rebChar) X(rebInteger) \
+    X(rebDecimal) X(rebSizedBinary) X(rebUninitializedBinary_internal) \
+    X(rebBinaryHead_internal) X(rebBinaryAt_internal) \
+    X(rebBinarySizeAt_internal) X(rebSizedText) X(rebText) \
+    X(rebLengthedTextWide) X(rebTextWide) X(rebHandle) X(rebArgR) \
+    X(rebArg) X(rebValue) X(rebQuote) X(rebElide) X(rebJumps) X(rebDid) \
+    X(rebNot) X(rebUnbox) X(rebUnbox0) X(rebUnboxInteger) \
+    X(rebUnboxInteger0) X(rebUnboxDecimal) X(rebUnboxChar) \
+    X(rebSpellInto) X(rebSpell) X(rebSpellIntoWide) X(rebSpellWide) \
+    X(rebBytesInto) X(rebBytes) X(rebRescue) X(rebRescueWith) X(rebHalt) \
+    X(rebQUOTING) X(rebUNQUOTING) X(rebRELEASING) X(rebManage) \
+    X(rebUnmanage) X(rebRelease) X(rebDeflateAlloc) X(rebZdeflateAlloc) \
+    X(rebGzipAlloc) X(rebInflateAlloc) X(rebZinflateAlloc) \
+    X(rebGunzipAlloc) X(rebDeflateDetectAlloc) X(rebFail_OS)
+
+#define LINKED_ENTRY(name) &RL_##name,
+
+SHIM_INTERPRETER Shim_Linked = {
+    { SHIM_RL_ENTRIES(LINKED_ENTRY) },
+    { .owners_lock = SHIM_LOCK_INIT }
+};
+
+SHIM_THREAD_LOCAL RL_LIB *Shim_Current = &Shim_Linked.lib;
+
+struct rebol_instance {
+    SHIM_INTERPRETER interpreter;
+    void *library;
+};
+
+static SHIM_THREAD_LOCAL REBINST *Entered = NULL;
+
+#else
+
+SHIM_STATE Shim_Linked_State = { .owners_lock = SHIM_LOCK_INIT };
+
+#endif
+
+RL_API REBINST * rebCreateInstance(const char * path) {
+  #if defined(SHIM_INSTANCES)
+    if (path == NULL)
+        path = "libr3.so";
+
+    REBINST *instance = (REBINST*)calloc(1, sizeof(REBINST));
+    if (instance == NULL) {
+        snprintf(Instance_Error, sizeof(Instance_Error), "out of memory");
+        return NULL;
+    }
+
+    instance->library = dlmopen(LM_ID_NEWLM, path, RTLD_NOW | RTLD_LOCAL);
+    if (instance->library == NULL) {
+        snprintf(Instance_Error, sizeof(Instance_Error), "%s", dlerror());
+        free(instance);
+        return NULL;
+    }
+
+    // POSIX's blessed way to get a function pointer out of dlsym()
+    #define LOOKUP_ENTRY(name) \
+        *(void**)&instance->interpreter.lib.name \
+            = dlsym(instance->library, "RL_" #name); \
+        if (instance->interpreter.lib.name == NULL) { \
+            snprintf( \
+                Instance_Error, sizeof(Instance_Error), \
+                "%s has no RL_" #name "()", path \
+            ); \
+            dlclose(instance->library); \
+            free(instance); \
+            return NULL; \
+        }
+    SHIM_RL_ENTRIES(LOOKUP_ENTRY)
+    #undef LOOKUP_ENTRY
+
+    Shim_Lock_Init(&instance->interpreter.state.owners_lock);
+    instance->interpreter.lib.rebStartup();
+    return instance;
+  #else
+    (void)path;
+    snprintf(
+        Instance_Error, sizeof(Instance_Error),
+        "shim was built without SHIM_INSTANCES"
+    );
+    return NULL;
+  #endif
+}
+
+RL_API void rebDestroyInstance(REBINST * instance) {
+  #if defined(SHIM_INSTANCES)
+    if (instance == NULL)
+        return;
+
+    // Through the shim's rebShutdown(), so it lets go of what it holds
+    // for the instance (see SHIM_STATE).  Clean, as the heap goes away
+    // with the library.
+    REBINST *previous = rebEnterInstance(instance);
+    rebShutdown(true);
+    rebEnterInstance(previous == instance ? NULL : previous);
+
+    Shim_Lock_Free(&instance->interpreter.state.owners_lock);
+    dlclose(instance->library);
+    free(instance);
+  #else
+    (void)instance;
+  #endif
+}
+
+RL_API REBINST * rebEnterInstance(REBINST * instance) {
+  #if defined(SHIM_INSTANCES)
+    REBINST *previous = Entered;
+    Entered = instance;
+    Shim_Current = instance ? &instance->interpreter.lib : &Shim_Linked.lib;
+    return previous;
+  #else
+    (void)instance;
+    return NULL;
+  #endif
+}
+
+RL_API const char * rebInstanceError(void) {
+    return Instance_Error;
+}
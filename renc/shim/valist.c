@@ -2,14 +2,315 @@
 #define RL_API __dllspec(dllimport)
 #endif
 #define REBOL_DISABLE_ACCESSOR_MACROS
+#include <assert.h>
+#include <errno.h>  // ENOMEM
+#include <stdio.h>  // sprintf()
+#include <string.h>  // memcpy(), strlen()
 #include "../include/rebol.h"
 
+#if !defined(WIN32)
+    #include <fcntl.h>  // open()
+    #include <sys/mman.h>  // mmap()
+    #include <sys/stat.h>  // fstat()
+    #include <unistd.h>  // close()
+#endif
+
 #ifdef WIN32
 #define RL_API __dllspec(dllexport)
 #else
 #define RL_API
 #endif
 
+#include "valist.h"
+#include "codec.h"
+#include "backend.h"
+#include "dispatch.h"
+
+//
+// Handle arenas (see rebOpenArena() at the end of the file)
+//
+// While an arena is open on a thread, every API handle the shim hands out
+// on that thread is pushed here, so closing the arena can release them all
+// at once.  Handles whose ownership goes elsewhere--rebRelease(), rebR(),
+// rebManage()--are taken back out, by clearing their entry (positions
+// have to stay put, as nested arenas are marked by them).  An index of
+// where each handle is, open-addressed by the handle's address, makes
+// finding one O(1) whatever order handles are let go of in.
+//
+// With instances, each has its arenas in its SHIM_STATE, so handles of
+// one never get released through another.  The linked interpreter's are
+// per thread (see %dispatch.h).
+//
+
+static SHIM_THREAD_LOCAL SHIM_ARENA Thread_Arena;
+
+inline static SHIM_ARENA *Current_Arena(void) {
+  #if defined(SHIM_INSTANCES)
+    if (Shim_Current != &Shim_Linked.lib)
+        return &Shim_State->arena;
+  #endif
+    return &Thread_Arena;
+}
+
+inline static size_t Arena_Hash(SHIM_ARENA *a, const REBVAL *v) {
+    uintptr_t h = (uintptr_t)v >> 4;  // cells are at least 16-byte aligned
+    return (size_t)(h * (uintptr_t)0x9E3779B97F4A7C15ull) & a->index_mask;
+}
+
+static void Index_Handle(SHIM_ARENA *a, size_t position) {
+    size_t slot = Arena_Hash(a, a->handles[position]);
+    while (a->index[slot] != 0)
+        slot = (slot + 1) & a->index_mask;
+    a->index[slot] = position + 1;
+}
+
+static void Unindex_Slot(SHIM_ARENA *a, size_t slot) {
+    // Backward-shift deletion: move up any later entry of the run that
+    // would no longer be found past the hole.
+    //
+    size_t hole = slot;
+    a->index[hole] = 0;
+    while (true) {
+        slot = (slot + 1) & a->index_mask;
+        if (a->index[slot] == 0)
+            return;
+        size_t home = Arena_Hash(a, a->handles[a->index[slot] - 1]);
+        if (((slot - home) & a->index_mask) >= ((slot - hole) & a->index_mask)) {
+            a->index[hole] = a->index[slot];
+            a->index[slot] = 0;
+            hole = slot;
+        }
+    }
+}
+
+static REBVAL *Track(REBVAL *v) {
+    SHIM_ARENA *a = Current_Arena();
+    if (a->depth == 0 || v == NULL)  // Rebol null is not a handle
+        return v;
+
+    if (a->count == a->capacity) {
+        size_t capacity = a->capacity == 0 ? 64 : a->capacity * 2;
+        const REBVAL **handles = (const REBVAL**)realloc(
+            (void*)a->handles, capacity * sizeof(const REBVAL*)
+        );
+        if (handles == NULL)
+            RL_rebFail_OS(ENOMEM);
+        a->handles = handles;
+
+        size_t *index = (size_t*)calloc(capacity * 2, sizeof(size_t));
+        if (index == NULL)
+            RL_rebFail_OS(ENOMEM);
+        free(a->index);
+        a->index = index;
+        a->index_mask = capacity * 2 - 1;
+        a->capacity = capacity;
+
+        size_t i;
+        for (i = 0; i < a->count; ++i)
+            if (a->handles[i] != NULL)
+                Index_Handle(a, i);
+    }
+    a->handles[a->count] = v;
+    Index_Handle(a, a->count++);
+    return v;
+}
+
+static void Untrack(const REBVAL *v) {
+    SHIM_ARENA *a = Current_Arena();
+    if (a->count == 0 || v == NULL)
+        return;
+
+    size_t slot = Arena_Hash(a, v);
+    while (a->index[slot] != 0) {
+        size_t position = a->index[slot] - 1;
+        if (a->handles[position] == v) {
+            Unindex_Slot(a, slot);
+            a->handles[position] = NULL;
+            return;
+        }
+        slot = (slot + 1) & a->index_mask;
+    }
+}
+
+static void Free_Arena(SHIM_ARENA *a) {
+    free((void*)a->handles);
+    free(a->index);
+    a->handles = NULL;
+    a->index = NULL;
+    a->count = a->capacity = a->index_mask = 0;
+    a->depth = 0;
+}
+
+//
+// Feeds
+//
+// RL_rebValue() and friends only take their input as a va_list*.  Rather
+// than marshal an array through a variadic call of some fixed arity, the
+// array variants build a va_list whose argument area *is* the array, so
+// each va_arg() the core does just reads the next item.  The layout of a
+// va_list is ABI-specific, hence the cases in Point_Va_List_At().
+//
+// The core stops at rebEND, so items[1..n-1] are copied with a rebEND on
+// the tail.  Short feeds use the stack; long ones use rebMalloc(), which
+// is reclaimed automatically if the evaluation fails out of the frame.
+//
+// Sized fragments (REBFRG, see %valist.h) are something only the shim
+// knows about: the core can only find the end of a UTF-8 fragment by its
+// NUL terminator.  So they are staged as terminated copies while the
+// feed's items are being copied anyway.  Variadic feeds are passed to the
+// core as they are, so only array feeds can have them.
+//
+
+#define SHIM_FEED_STACK_ITEMS 16
+#define SHIM_FEED_STAGE_BYTES 256
+
+typedef struct {
+    const void *stack[SHIM_FEED_STACK_ITEMS];
+    const void **items;  // rebMalloc()'d when stack is too small
+    char stage[SHIM_FEED_STAGE_BYTES];
+    char *staged;  // rebMalloc()'d when stage is too small
+    va_list va;
+} SHIM_FEED;
+
+inline static bool Is_Feed_End(const void *p) {
+    const unsigned char *bp = (const unsigned char*)p;
+    return bp != NULL && bp[0] == 0x80 && bp[1] == 0;
+}
+
+inline static bool Is_Sized_Fragment(const void *p) {
+    return p != NULL
+        && ((const unsigned char*)p)[0] == REBOL_SIZED_FRAGMENT_BYTE;
+}
+
+static void Point_Va_List_At(va_list *va, const void **args) {
+  #if defined(__x86_64__) && !defined(_WIN32)
+    //
+    // System V: a va_list records how much of the register save area has
+    // been consumed.  Saying all of it has makes va_arg() read from the
+    // overflow area, stepping 8 bytes per pointer.
+    //
+    struct {
+        unsigned int gp_offset;
+        unsigned int fp_offset;
+        void *overflow_arg_area;
+        void *reg_save_area;
+    } sysv;
+    sysv.gp_offset = 6 * 8;  // rdi, rsi, rdx, rcx, r8, r9
+    sysv.fp_offset = 6 * 8 + 8 * 16;  // xmm0-xmm7
+    sysv.overflow_arg_area = (void*)args;
+    sysv.reg_save_area = NULL;
+    memcpy(va, &sysv, sizeof(sysv));
+  #elif defined(__aarch64__) && !defined(__APPLE__) && !defined(_WIN32)
+    //
+    // AAPCS64: non-negative register offsets mean the registers are used
+    // up and arguments come from __stack, one 8 byte slot per pointer.
+    //
+    struct {
+        void *stack;
+        void *gr_top;
+        void *vr_top;
+        int gr_offs;
+        int vr_offs;
+    } aapcs;
+    aapcs.stack = (void*)args;
+    aapcs.gr_top = NULL;
+    aapcs.vr_top = NULL;
+    aapcs.gr_offs = 0;
+    aapcs.vr_offs = 0;
+    memcpy(va, &aapcs, sizeof(aapcs));
+  #elif defined(_WIN32) || defined(__APPLE__) || defined(__i386__) \
+        || defined(__arm__)
+    //
+    // va_list is a plain pointer walking pointer-sized argument slots.
+    //
+    const void *ap = args;
+    memcpy(va, &ap, sizeof(ap));
+  #else
+    #error "Array feeds need the va_list layout for this ABI"
+  #endif
+}
+
+// Replace any sized fragments in items[0..n-1] with terminated copies.
+//
+static void Stage_Sized_Fragments(SHIM_FEED *feed, const void **items, size_t n) {
+    size_t size = 0;
+    size_t i;
+    for (i = 0; i < n; ++i)
+        if (Is_Sized_Fragment(items[i]))
+            size += ((const REBFRG*)items[i])->size + 1;
+    if (size == 0)
+        return;
+
+    char *tail = size <= SHIM_FEED_STAGE_BYTES
+        ? feed->stage
+        : (feed->staged = (char*)RL_rebMalloc(size));
+
+    for (i = 0; i < n; ++i) {
+        if (!Is_Sized_Fragment(items[i]))
+            continue;
+        const REBFRG *frag = (const REBFRG*)items[i];
+        memcpy(tail, frag->utf8, frag->size);
+        tail[frag->size] = '\0';
+        items[i] = tail;
+        tail += frag->size + 1;
+    }
+}
+
+static const void *Init_Array_Feed(
+    SHIM_FEED *feed,
+    const void * const *items,
+    size_t n
+){
+    feed->items = NULL;
+    feed->staged = NULL;
+
+    if (n == 0)  // core sees the end immediately, never touches the va
+        return rebEND;
+
+    const void **copy = n <= SHIM_FEED_STACK_ITEMS
+        ? feed->stack
+        : (feed->items = (const void**)RL_rebMalloc(n * sizeof(const void*)));
+
+    // The first item is passed to the core separately from the va_list,
+    // so it goes on the tail, where it can be staged with the rest.
+    //
+    memcpy(copy, items + 1, (n - 1) * sizeof(const void*));
+    copy[n - 1] = items[0];
+    Stage_Sized_Fragments(feed, copy, n);
+
+    const void *p = copy[n - 1];
+    copy[n - 1] = rebEND;
+    Point_Va_List_At(&feed->va, copy);
+    return p;
+}
+
+static void Drop_Feed(SHIM_FEED *feed) {
+    if (feed->items)
+        RL_rebFree(feed->items);
+    if (feed->staged)
+        RL_rebFree(feed->staged);
+}
+
+//
+// For the shim's own use of the evaluator: values spliced into these are
+// quoted (so they're used as-is), and results aren't put in any arena.
+//
+
+static REBVAL *Value_Internal(const void *p, ...) {
+    va_list va; va_start(va, p);
+    return RL_rebValue(1, p, &va);
+}
+
+static void Elide_Internal(const void *p, ...) {
+    va_list va; va_start(va, p);
+    RL_rebElide(1, p, &va);
+}
+
+static bool Did_Internal(const void *p, ...) {
+    va_list va; va_start(va, p);
+    return RL_rebDid(1, p, &va);
+}
+
 RL_API void * rebMalloc(size_t size) {
     RL_rebEnterApi_internal();
      return RL_rebMalloc(size);
@@ -27,18 +328,34 @@ RL_API void rebFree(void * ptr) {
 
 RL_API REBVAL * rebRepossess(void * ptr, size_t size) {
     RL_rebEnterApi_internal();
-     return RL_rebRepossess(ptr, size);
+     return Track(RL_rebRepossess(ptr, size));
  }
 
 RL_API void rebStartup(void) {
      RL_rebStartup();
  }
 
+static void Drop_Checkpoint(void);
+static void Drop_Owners(void);
+static void Drop_Pins(void);
+
 RL_API void rebShutdown(bool clean) {
     RL_rebEnterApi_internal();
+     Drop_Checkpoint();
      RL_rebShutdown(clean);
+     Free_Arena(Current_Arena());
+     Drop_Owners();
+     Drop_Pins();
+     Backend_Free(Shim_State->backend);
+     Shim_State->backend = NULL;
  }
 
+RL_API void rebShutdownFast(void) {
+    RL_rebEnterApi_internal();
+    fflush(NULL);  // all output streams
+    RL_rebShutdown(false);
+}
+
 RL_API uintptr_t rebTick(void) {
     RL_rebEnterApi_internal();
      return RL_rebTick();
@@ -46,42 +363,42 @@ RL_API uintptr_t rebTick(void) {
 
 RL_API REBVAL * rebVoid(void) {
     RL_rebEnterApi_internal();
-     return RL_rebVoid();
+     return Track(RL_rebVoid());
  }
 
 RL_API REBVAL * rebBlank(void) {
     RL_rebEnterApi_internal();
-     return RL_rebBlank();
+     return Track(RL_rebBlank());
  }
 
 RL_API REBVAL * rebLogic(bool logic) {
     RL_rebEnterApi_internal();
-     return RL_rebLogic(logic);
+     return Track(RL_rebLogic(logic));
  }
 
 RL_API REBVAL * rebChar(uint32_t codepoint) {
     RL_rebEnterApi_internal();
-     return RL_rebChar(codepoint);
+     return Track(RL_rebChar(codepoint));
  }
 
 RL_API REBVAL * rebInteger(int64_t i) {
     RL_rebEnterApi_internal();
-     return RL_rebInteger(i);
+     return Track(RL_rebInteger(i));
  }
 
 RL_API REBVAL * rebDecimal(double dec) {
     RL_rebEnterApi_internal();
-     return RL_rebDecimal(dec);
+     return Track(RL_rebDecimal(dec));
  }
 
 RL_API REBVAL * rebSizedBinary(const void * bytes, size_t size) {
     RL_rebEnterApi_internal();
-     return RL_rebSizedBinary(bytes, size);
+     return Track(RL_rebSizedBinary(bytes, size));
  }
 
 RL_API REBVAL * rebUninitializedBinary_internal(size_t size) {
     RL_rebEnterApi_internal();
-     return RL_rebUninitializedBinary_internal(size);
+     return Track(RL_rebUninitializedBinary_internal(size));
  }
 
 RL_API unsigned char * rebBinaryHead_internal(const REBVAL * binary) {
@@ -101,27 +418,27 @@ RL_API unsigned int rebBinarySizeAt_internal(const REBVAL * binary) {
 
 RL_API REBVAL * rebSizedText(const char * utf8, size_t size) {
     RL_rebEnterApi_internal();
-     return RL_rebSizedText(utf8, size);
+     return Track(RL_rebSizedText(utf8, size));
  }
 
 RL_API REBVAL * rebText(const char * utf8) {
     RL_rebEnterApi_internal();
-     return RL_rebText(utf8);
+     return Track(RL_rebText(utf8));
  }
 
 RL_API REBVAL * rebLengthedTextWide(const REBWCHAR * wstr, unsigned int num_chars) {
     RL_rebEnterApi_internal();
-     return RL_rebLengthedTextWide(wstr, num_chars);
+     return Track(RL_rebLengthedTextWide(wstr, num_chars));
  }
 
 RL_API REBVAL * rebTextWide(const REBWCHAR * wstr) {
     RL_rebEnterApi_internal();
-     return RL_rebTextWide(wstr);
+     return Track(RL_rebTextWide(wstr));
  }
 
 RL_API REBVAL * rebHandle(void * data, size_t length, CLEANUP_CFUNC * cleaner) {
     RL_rebEnterApi_internal();
-     return RL_rebHandle(data, length, cleaner);
+     return Track(RL_rebHandle(data, length, cleaner));
  }
 
 RL_API const void * rebArgR(const void *p, ...) {
@@ -139,37 +456,37 @@ RL_API const void * rebArgRQ(const void *p, ...) {
 RL_API REBVAL * rebArg(const void *p, ...) {
     RL_rebEnterApi_internal();
     va_list va; va_start(va, p);
-    return RL_rebArg(0, p, &va);
+    return Track(RL_rebArg(0, p, &va));
  }
 
 RL_API REBVAL * rebArgQ(const void *p, ...) {
     RL_rebEnterApi_internal();
     va_list va; va_start(va, p);
-    return RL_rebArg(1, p, &va);
+    return Track(RL_rebArg(1, p, &va));
  }
 
 RL_API REBVAL * rebValue(const void *p, ...) {
     RL_rebEnterApi_internal();
     va_list va; va_start(va, p);
-    return RL_rebValue(0, p, &va);
+    return Track(RL_rebValue(0, p, &va));
  }
 
 RL_API REBVAL * rebValueQ(const void *p, ...) {
     RL_rebEnterApi_internal();
     va_list va; va_start(va, p);
-    return RL_rebValue(1, p, &va);
+    return Track(RL_rebValue(1, p, &va));
  }
 
 RL_API REBVAL * rebQuote(const void *p, ...) {
     RL_rebEnterApi_internal();
     va_list va; va_start(va, p);
-    return RL_rebQuote(0, p, &va);
+    return Track(RL_rebQuote(0, p, &va));
  }
 
 RL_API REBVAL * rebQuoteQ(const void *p, ...) {
     RL_rebEnterApi_internal();
     va_list va; va_start(va, p);
-    return RL_rebQuote(1, p, &va);
+    return Track(RL_rebQuote(1, p, &va));
  }
 
 RL_API void rebElide(const void *p, ...) {
@@ -356,12 +673,12 @@ RL_API unsigned char * rebBytesQ(size_t * size_out, const void *p, ...) {
 
 RL_API REBVAL * rebRescue(REBDNG * dangerous, void * opaque) {
     RL_rebEnterApi_internal();
-     return RL_rebRescue(dangerous, opaque);
+     return Track(RL_rebRescue(dangerous, opaque));
  }
 
 RL_API REBVAL * rebRescueWith(REBDNG * dangerous, REBRSC * rescuer, void * opaque) {
     RL_rebEnterApi_internal();
-     return RL_rebRescueWith(dangerous, rescuer, opaque);
+     return Track(RL_rebRescueWith(dangerous, rescuer, opaque));
  }
 
 RL_API void rebHalt(void) {
@@ -395,11 +712,13 @@ RL_API const void * rebUNQUOTINGQ(const void *p, ...) {
 
 RL_API const void * rebRELEASING(REBVAL * v) {
     RL_rebEnterApi_internal();
+    Untrack(v);
      return RL_rebRELEASING(v);
  }
 
 RL_API REBVAL * rebManage(REBVAL * v) {
     RL_rebEnterApi_internal();
+    Untrack(v);
      return RL_rebManage(v);
  }
 
@@ -410,42 +729,71 @@ RL_API void rebUnmanage(void * p) {
 
 RL_API void rebRelease(const REBVAL * v) {
     RL_rebEnterApi_internal();
+    Untrack(v);
      RL_rebRelease(v);
  }
 
 RL_API void * rebDeflateAlloc(size_t * out_len, const void * input, size_t in_len) {
     RL_rebEnterApi_internal();
+  #if defined(SHIM_DEFLATE_BACKEND)
+    return Backend_Compress_Alloc(out_len, input, in_len, REB_CODEC_DEFLATE);
+  #else
      return RL_rebDeflateAlloc(out_len, input, in_len);
+  #endif
  }
 
 RL_API void * rebZdeflateAlloc(size_t * out_len, const void * input, size_t in_len) {
     RL_rebEnterApi_internal();
+  #if defined(SHIM_DEFLATE_BACKEND)
+    return Backend_Compress_Alloc(out_len, input, in_len, REB_CODEC_ZLIB);
+  #else
      return RL_rebZdeflateAlloc(out_len, input, in_len);
+  #endif
  }
 
 RL_API void * rebGzipAlloc(size_t * out_len, const void * input, size_t in_len) {
     RL_rebEnterApi_internal();
+  #if defined(SHIM_DEFLATE_BACKEND)
+    return Backend_Compress_Alloc(out_len, input, in_len, REB_CODEC_GZIP);
+  #else
      return RL_rebGzipAlloc(out_len, input, in_len);
+  #endif
  }
 
 RL_API void * rebInflateAlloc(size_t * len_out, const void * input, size_t len_in, int max) {
     RL_rebEnterApi_internal();
+  #if defined(SHIM_DEFLATE_BACKEND)
+    int format = REB_CODEC_DEFLATE;
+    return Backend_Decompress_Alloc(len_out, input, len_in, max, &format, 0);
+  #else
      return RL_rebInflateAlloc(len_out, input, len_in, max);
+  #endif
  }
 
 RL_API void * rebZinflateAlloc(size_t * len_out, const void * input, size_t len_in, int max) {
     RL_rebEnterApi_internal();
+  #if defined(SHIM_DEFLATE_BACKEND)
+    int format = REB_CODEC_ZLIB;
+    return Backend_Decompress_Alloc(len_out, input, len_in, max, &format, 0);
+  #else
      return RL_rebZinflateAlloc(len_out, input, len_in, max);
+  #endif
  }
 
 RL_API void * rebGunzipAlloc(size_t * len_out, const void * input, size_t len_in, int max) {
     RL_rebEnterApi_internal();
+  #if defined(SHIM_DEFLATE_BACKEND)
+    int format = REB_CODEC_GZIP;
+    return Backend_Decompress_Alloc(len_out, input, len_in, max, &format, 0);
+  #else
      return RL_rebGunzipAlloc(len_out, input, len_in, max);
+  #endif
  }
 
 RL_API void * rebDeflateDetectAlloc(size_t * len_out, const void * input, size_t len_in, int max) {
     RL_rebEnterApi_internal();
-     return RL_rebDeflateDetectAlloc(len_out, input, len_in, max);
+    int format = -1;
+    return Backend_Decompress_Alloc(len_out, input, len_in, max, &format, 0);
  }
 
 ATTRIBUTE_NO_RETURN
@@ -455,3 +803,1204 @@ RL_API void rebFail_OS(int errnum) {
     DEAD_END;
 }
 
+RL_API const char * rebDeflateBackend(void) {
+    return Backend_Name;
+}
+
+RL_API void * rebDecompressAlloc(size_t * len_out, int * format, const void * input, size_t len_in, int max, size_t size_hint) {
+    RL_rebEnterApi_internal();
+    return Backend_Decompress_Alloc(len_out, input, len_in, max, format, size_hint);
+}
+
+
+
+RL_API REBVAL * rebValueArray(const void * const * items, size_t n) {
+    RL_rebEnterApi_internal();
+    SHIM_FEED feed; const void *p = Init_Array_Feed(&feed, items, n);
+    REBVAL *result = Track(RL_rebValue(0, p, &feed.va));
+    Drop_Feed(&feed);
+    return result;
+}
+
+RL_API REBVAL * rebValueArrayQ(const void * const * items, size_t n) {
+    RL_rebEnterApi_internal();
+    SHIM_FEED feed; const void *p = Init_Array_Feed(&feed, items, n);
+    REBVAL *result = Track(RL_rebValue(1, p, &feed.va));
+    Drop_Feed(&feed);
+    return result;
+}
+
+RL_API REBVAL * rebQuoteArray(const void * const * items, size_t n) {
+    RL_rebEnterApi_internal();
+    SHIM_FEED feed; const void *p = Init_Array_Feed(&feed, items, n);
+    REBVAL *result = Track(RL_rebQuote(0, p, &feed.va));
+    Drop_Feed(&feed);
+    return result;
+}
+
+RL_API REBVAL * rebQuoteArrayQ(const void * const * items, size_t n) {
+    RL_rebEnterApi_internal();
+    SHIM_FEED feed; const void *p = Init_Array_Feed(&feed, items, n);
+    REBVAL *result = Track(RL_rebQuote(1, p, &feed.va));
+    Drop_Feed(&feed);
+    return result;
+}
+
+RL_API void rebElideArray(const void * const * items, size_t n) {
+    RL_rebEnterApi_internal();
+    SHIM_FEED feed; const void *p = Init_Array_Feed(&feed, items, n);
+    RL_rebElide(0, p, &feed.va);
+    Drop_Feed(&feed);
+}
+
+RL_API void rebElideArrayQ(const void * const * items, size_t n) {
+    RL_rebEnterApi_internal();
+    SHIM_FEED feed; const void *p = Init_Array_Feed(&feed, items, n);
+    RL_rebElide(1, p, &feed.va);
+    Drop_Feed(&feed);
+}
+
+RL_API bool rebDidArray(const void * const * items, size_t n) {
+    RL_rebEnterApi_internal();
+    SHIM_FEED feed; const void *p = Init_Array_Feed(&feed, items, n);
+    bool result = RL_rebDid(0, p, &feed.va);
+    Drop_Feed(&feed);
+    return result;
+}
+
+RL_API bool rebDidArrayQ(const void * const * items, size_t n) {
+    RL_rebEnterApi_internal();
+    SHIM_FEED feed; const void *p = Init_Array_Feed(&feed, items, n);
+    bool result = RL_rebDid(1, p, &feed.va);
+    Drop_Feed(&feed);
+    return result;
+}
+
+RL_API bool rebNotArray(const void * const * items, size_t n) {
+    RL_rebEnterApi_internal();
+    SHIM_FEED feed; const void *p = Init_Array_Feed(&feed, items, n);
+    bool result = RL_rebNot(0, p, &feed.va);
+    Drop_Feed(&feed);
+    return result;
+}
+
+RL_API bool rebNotArrayQ(const void * const * items, size_t n) {
+    RL_rebEnterApi_internal();
+    SHIM_FEED feed; const void *p = Init_Array_Feed(&feed, items, n);
+    bool result = RL_rebNot(1, p, &feed.va);
+    Drop_Feed(&feed);
+    return result;
+}
+
+RL_API intptr_t rebUnboxArray(const void * const * items, size_t n) {
+    RL_rebEnterApi_internal();
+    SHIM_FEED feed; const void *p = Init_Array_Feed(&feed, items, n);
+    intptr_t result = RL_rebUnbox(0, p, &feed.va);
+    Drop_Feed(&feed);
+    return result;
+}
+
+RL_API intptr_t rebUnboxArrayQ(const void * const * items, size_t n) {
+    RL_rebEnterApi_internal();
+    SHIM_FEED feed; const void *p = Init_Array_Feed(&feed, items, n);
+    intptr_t result = RL_rebUnbox(1, p, &feed.va);
+    Drop_Feed(&feed);
+    return result;
+}
+
+RL_API intptr_t rebUnboxIntegerArray(const void * const * items, size_t n) {
+    RL_rebEnterApi_internal();
+    SHIM_FEED feed; const void *p = Init_Array_Feed(&feed, items, n);
+    intptr_t result = RL_rebUnboxInteger(0, p, &feed.va);
+    Drop_Feed(&feed);
+    return result;
+}
+
+RL_API intptr_t rebUnboxIntegerArrayQ(const void * const * items, size_t n) {
+    RL_rebEnterApi_internal();
+    SHIM_FEED feed; const void *p = Init_Array_Feed(&feed, items, n);
+    intptr_t result = RL_rebUnboxInteger(1, p, &feed.va);
+    Drop_Feed(&feed);
+    return result;
+}
+
+RL_API double rebUnboxDecimalArray(const void * const * items, size_t n) {
+    RL_rebEnterApi_internal();
+    SHIM_FEED feed; const void *p = Init_Array_Feed(&feed, items, n);
+    double result = RL_rebUnboxDecimal(0, p, &feed.va);
+    Drop_Feed(&feed);
+    return result;
+}
+
+RL_API double rebUnboxDecimalArrayQ(const void * const * items, size_t n) {
+    RL_rebEnterApi_internal();
+    SHIM_FEED feed; const void *p = Init_Array_Feed(&feed, items, n);
+    double result = RL_rebUnboxDecimal(1, p, &feed.va);
+    Drop_Feed(&feed);
+    return result;
+}
+
+RL_API uint32_t rebUnboxCharArray(const void * const * items, size_t n) {
+    RL_rebEnterApi_internal();
+    SHIM_FEED feed; const void *p = Init_Array_Feed(&feed, items, n);
+    uint32_t result = RL_rebUnboxChar(0, p, &feed.va);
+    Drop_Feed(&feed);
+    return result;
+}
+
+RL_API uint32_t rebUnboxCharArrayQ(const void * const * items, size_t n) {
+    RL_rebEnterApi_internal();
+    SHIM_FEED feed; const void *p = Init_Array_Feed(&feed, items, n);
+    uint32_t result = RL_rebUnboxChar(1, p, &feed.va);
+    Drop_Feed(&feed);
+    return result;
+}
+
+RL_API size_t rebSpellIntoArray(char * buf, size_t buf_size, const void * const * items, size_t n) {
+    RL_rebEnterApi_internal();
+    SHIM_FEED feed; const void *p = Init_Array_Feed(&feed, items, n);
+    size_t result = RL_rebSpellInto(0, buf, buf_size, p, &feed.va);
+    Drop_Feed(&feed);
+    return result;
+}
+
+RL_API size_t rebSpellIntoArrayQ(char * buf, size_t buf_size, const void * const * items, size_t n) {
+    RL_rebEnterApi_internal();
+    SHIM_FEED feed; const void *p = Init_Array_Feed(&feed, items, n);
+    size_t result = RL_rebSpellInto(1, buf, buf_size, p, &feed.va);
+    Drop_Feed(&feed);
+    return result;
+}
+
+RL_API char * rebSpellArray(const void * const * items, size_t n) {
+    RL_rebEnterApi_internal();
+    SHIM_FEED feed; const void *p = Init_Array_Feed(&feed, items, n);
+    char *result = RL_rebSpell(0, p, &feed.va);
+    Drop_Feed(&feed);
+    return result;
+}
+
+RL_API char * rebSpellArrayQ(const void * const * items, size_t n) {
+    RL_rebEnterApi_internal();
+    SHIM_FEED feed; const void *p = Init_Array_Feed(&feed, items, n);
+    char *result = RL_rebSpell(1, p, &feed.va);
+    Drop_Feed(&feed);
+    return result;
+}
+
+RL_API size_t rebBytesIntoArray(unsigned char * buf, size_t buf_size, const void * const * items, size_t n) {
+    RL_rebEnterApi_internal();
+    SHIM_FEED feed; const void *p = Init_Array_Feed(&feed, items, n);
+    size_t result = RL_rebBytesInto(0, buf, buf_size, p, &feed.va);
+    Drop_Feed(&feed);
+    return result;
+}
+
+RL_API size_t rebBytesIntoArrayQ(unsigned char * buf, size_t buf_size, const void * const * items, size_t n) {
+    RL_rebEnterApi_internal();
+    SHIM_FEED feed; const void *p = Init_Array_Feed(&feed, items, n);
+    size_t result = RL_rebBytesInto(1, buf, buf_size, p, &feed.va);
+    Drop_Feed(&feed);
+    return result;
+}
+
+RL_API unsigned char * rebBytesArray(size_t * size_out, const void * const * items, size_t n) {
+    RL_rebEnterApi_internal();
+    SHIM_FEED feed; const void *p = Init_Array_Feed(&feed, items, n);
+    unsigned char *result = RL_rebBytes(0, size_out, p, &feed.va);
+    Drop_Feed(&feed);
+    return result;
+}
+
+RL_API unsigned char * rebBytesArrayQ(size_t * size_out, const void * const * items, size_t n) {
+    RL_rebEnterApi_internal();
+    SHIM_FEED feed; const void *p = Init_Array_Feed(&feed, items, n);
+    unsigned char *result = RL_rebBytes(1, size_out, p, &feed.va);
+    Drop_Feed(&feed);
+    return result;
+}
+
+
+//
+// Prepared evaluation
+//
+// The fragments are turned into the source of a FUNC whose parameters are
+// the slots, e.g. {"1 +", ""} becomes:
+//
+//     func [rebslot-1] [
+//     1 +
+//      rebslot-1
+//     ]
+//
+// Each fragment goes on its own line so a trailing `;` comment in one
+// can't swallow the slot that follows it.  Running the prepared handle is
+// then just splicing the ACTION! and its arguments into a feed.
+//
+
+#define SHIM_SLOT_PREFIX "rebslot-"
+
+RL_API REBVAL * rebPrepare(const char * const * fragments, size_t num_fragments) {
+    RL_rebEnterApi_internal();
+
+    size_t num_slots = num_fragments == 0 ? 0 : num_fragments - 1;
+    size_t slot_max = sizeof(SHIM_SLOT_PREFIX) + 20 + 3;  // " name \n"
+
+    size_t size = sizeof("func [] [\n]") + 2 * num_slots * slot_max;
+    size_t i;
+    for (i = 0; i < num_fragments; ++i)
+        size += strlen(fragments[i]) + 1;
+
+    char *source = (char*)RL_rebMalloc(size);
+    char *tail = source;
+
+    tail += sprintf(tail, "func [");
+    for (i = 1; i <= num_slots; ++i)
+        tail += sprintf(tail, " " SHIM_SLOT_PREFIX "%lu", (unsigned long)i);
+    tail += sprintf(tail, "] [\n");
+    for (i = 0; i < num_fragments; ++i) {
+        if (i != 0)
+            tail += sprintf(
+                tail, " " SHIM_SLOT_PREFIX "%lu\n", (unsigned long)i
+            );
+        tail += sprintf(tail, "%s\n", fragments[i]);
+    }
+    sprintf(tail, "]");
+
+    const void *item = source;
+    SHIM_FEED feed; const void *p = Init_Array_Feed(&feed, &item, 1);
+    REBVAL *prepared = Track(RL_rebValue(0, p, &feed.va));
+    Drop_Feed(&feed);
+
+    RL_rebFree(source);
+    return prepared;
+}
+
+static const void *Init_Prepared_Feed(
+    SHIM_FEED *feed,
+    const REBVAL *prepared,
+    const REBVAL * const *args,
+    size_t num_args
+){
+    const void *stack[SHIM_FEED_STACK_ITEMS];
+    const void **items = num_args < SHIM_FEED_STACK_ITEMS
+        ? stack
+        : (const void**)RL_rebMalloc((num_args + 1) * sizeof(const void*));
+
+    items[0] = prepared;
+    memcpy(items + 1, args, num_args * sizeof(const void*));
+
+    const void *p = Init_Array_Feed(feed, items, num_args + 1);
+    if (items != stack)
+        RL_rebFree(items);
+    return p;
+}
+
+RL_API REBVAL * rebRunPrepared(const REBVAL * prepared, const REBVAL * const * args, size_t num_args) {
+    RL_rebEnterApi_internal();
+    SHIM_FEED feed;
+    const void *p = Init_Prepared_Feed(&feed, prepared, args, num_args);
+    REBVAL *result = Track(RL_rebValue(0, p, &feed.va));
+    Drop_Feed(&feed);
+    return result;
+}
+
+RL_API void rebElidePrepared(const REBVAL * prepared, const REBVAL * const * args, size_t num_args) {
+    RL_rebEnterApi_internal();
+    SHIM_FEED feed;
+    const void *p = Init_Prepared_Feed(&feed, prepared, args, num_args);
+    RL_rebElide(0, p, &feed.va);
+    Drop_Feed(&feed);
+}
+
+
+//
+// API sessions
+//
+// RL_rebEnterApi_internal() only has to be done once for a run of calls
+// from the same thread, so a session does it up front and the _entered
+// entry points call straight through.  The depth is kept per-thread so
+// debug builds can catch an _entered call made outside of a session.
+//
+
+static SHIM_THREAD_LOCAL unsigned int Session_Depth = 0;
+
+#define ASSERT_SESSION() \
+    assert(Session_Depth != 0 && "_entered API call outside of a session")
+
+RL_API void rebEnterSession(void) {
+    RL_rebEnterApi_internal();
+    ++Session_Depth;
+}
+
+RL_API void rebLeaveSession(void) {
+    assert(Session_Depth != 0);
+    --Session_Depth;
+}
+
+RL_API REBVAL * rebVoid_entered(void) {
+    ASSERT_SESSION();
+    return Track(RL_rebVoid());
+}
+
+RL_API REBVAL * rebBlank_entered(void) {
+    ASSERT_SESSION();
+    return Track(RL_rebBlank());
+}
+
+RL_API REBVAL * rebLogic_entered(bool logic) {
+    ASSERT_SESSION();
+    return Track(RL_rebLogic(logic));
+}
+
+RL_API REBVAL * rebChar_entered(uint32_t codepoint) {
+    ASSERT_SESSION();
+    return Track(RL_rebChar(codepoint));
+}
+
+RL_API REBVAL * rebInteger_entered(int64_t i) {
+    ASSERT_SESSION();
+    return Track(RL_rebInteger(i));
+}
+
+RL_API REBVAL * rebDecimal_entered(double dec) {
+    ASSERT_SESSION();
+    return Track(RL_rebDecimal(dec));
+}
+
+RL_API REBVAL * rebSizedBinary_entered(const void * bytes, size_t size) {
+    ASSERT_SESSION();
+    return Track(RL_rebSizedBinary(bytes, size));
+}
+
+RL_API REBVAL * rebSizedText_entered(const char * utf8, size_t size) {
+    ASSERT_SESSION();
+    return Track(RL_rebSizedText(utf8, size));
+}
+
+RL_API REBVAL * rebText_entered(const char * utf8) {
+    ASSERT_SESSION();
+    return Track(RL_rebText(utf8));
+}
+
+RL_API REBVAL * rebValue_entered(const void *p, ...) {
+    ASSERT_SESSION();
+    va_list va; va_start(va, p);
+    return Track(RL_rebValue(0, p, &va));
+}
+
+RL_API void rebElide_entered(const void *p, ...) {
+    ASSERT_SESSION();
+    va_list va; va_start(va, p);
+    RL_rebElide(0, p, &va);
+}
+
+RL_API bool rebDid_entered(const void *p, ...) {
+    ASSERT_SESSION();
+    va_list va; va_start(va, p);
+    return RL_rebDid(0, p, &va);
+}
+
+RL_API intptr_t rebUnboxInteger_entered(const void *p, ...) {
+    ASSERT_SESSION();
+    va_list va; va_start(va, p);
+    return RL_rebUnboxInteger(0, p, &va);
+}
+
+RL_API intptr_t rebUnbox0_entered(const void * p) {
+    ASSERT_SESSION();
+    return RL_rebUnbox0(p);
+}
+
+RL_API intptr_t rebUnboxInteger0_entered(const void * p) {
+    ASSERT_SESSION();
+    return RL_rebUnboxInteger0(p);
+}
+
+RL_API void rebRelease_entered(const REBVAL * v) {
+    ASSERT_SESSION();
+    Untrack(v);
+    RL_rebRelease(v);
+}
+
+RL_API REBVAL * rebValueArray_entered(const void * const * items, size_t n) {
+    ASSERT_SESSION();
+    SHIM_FEED feed; const void *p = Init_Array_Feed(&feed, items, n);
+    REBVAL *result = Track(RL_rebValue(0, p, &feed.va));
+    Drop_Feed(&feed);
+    return result;
+}
+
+RL_API void rebElideArray_entered(const void * const * items, size_t n) {
+    ASSERT_SESSION();
+    SHIM_FEED feed; const void *p = Init_Array_Feed(&feed, items, n);
+    RL_rebElide(0, p, &feed.va);
+    Drop_Feed(&feed);
+}
+
+RL_API REBVAL * rebRunPrepared_entered(const REBVAL * prepared, const REBVAL * const * args, size_t num_args) {
+    ASSERT_SESSION();
+    SHIM_FEED feed;
+    const void *p = Init_Prepared_Feed(&feed, prepared, args, num_args);
+    REBVAL *result = Track(RL_rebValue(0, p, &feed.va));
+    Drop_Feed(&feed);
+    return result;
+}
+
+
+//
+// Handle arenas
+//
+// rebOpenArena() returns a mark, and rebCloseArena() releases all handles
+// made on the thread since that mark (arenas nest).  A handle that must
+// outlive its arena can be taken out with rebUnarena().
+//
+
+RL_API size_t rebOpenArena(void) {
+    SHIM_ARENA *a = Current_Arena();
+    ++a->depth;
+    return a->count;
+}
+
+RL_API void rebCloseArena(size_t mark) {
+    SHIM_ARENA *a = Current_Arena();
+    assert(a->depth != 0 && mark <= a->count);
+
+    if (a->count != mark) {
+        RL_rebEnterApi_internal();
+        while (a->count != mark) {
+            const REBVAL *v = a->handles[a->count - 1];
+            Untrack(v);
+            --a->count;
+            if (v != NULL)
+                RL_rebRelease(v);
+        }
+    }
+    --a->depth;
+}
+
+RL_API REBVAL * rebUnarena(REBVAL * v) {
+    Untrack(v);
+    return v;
+}
+
+RL_API void rebReleaseMany(const REBVAL * const * v, size_t n) {
+    RL_rebEnterApi_internal();
+    size_t i;
+    for (i = 0; i < n; ++i) {
+        Untrack(v[i]);
+        RL_rebRelease(v[i]);
+    }
+}
+
+
+//
+// Growable spell and bytes
+//
+// The feed is evaluated once into a temporary value.  That value is then
+// spliced quoted (so it is taken as-is, not evaluated again) into two
+// cheap rebSpellInto()/rebBytesInto() calls: one to size, one to fill.
+//
+
+static size_t Spell_Into_Grow(REBVAL *v, REBGRW *grow, void *opaque) {
+    const void *item = v;
+    SHIM_FEED feed; const void *p = Init_Array_Feed(&feed, &item, 1);
+    size_t size = RL_rebSpellInto(1, NULL, 0, p, &feed.va);
+    Drop_Feed(&feed);
+
+    char *buf = (char*)grow(opaque, size + 1);
+    if (buf == NULL) {
+        if (v)
+            RL_rebRelease(v);
+        RL_rebFail_OS(ENOMEM);
+    }
+
+    p = Init_Array_Feed(&feed, &item, 1);
+    RL_rebSpellInto(1, buf, size, p, &feed.va);
+    Drop_Feed(&feed);
+
+    if (v)
+        RL_rebRelease(v);
+    return size;
+}
+
+static size_t Bytes_Into_Grow(REBVAL *v, REBGRW *grow, void *opaque) {
+    const void *item = v;
+    SHIM_FEED feed; const void *p = Init_Array_Feed(&feed, &item, 1);
+    size_t size = RL_rebBytesInto(1, NULL, 0, p, &feed.va);
+    Drop_Feed(&feed);
+
+    unsigned char *buf = (unsigned char*)grow(opaque, size);
+    if (buf == NULL && size != 0) {
+        if (v)
+            RL_rebRelease(v);
+        RL_rebFail_OS(ENOMEM);
+    }
+
+    if (size != 0) {
+        p = Init_Array_Feed(&feed, &item, 1);
+        RL_rebBytesInto(1, buf, size, p, &feed.va);
+        Drop_Feed(&feed);
+    }
+
+    if (v)
+        RL_rebRelease(v);
+    return size;
+}
+
+RL_API size_t rebSpellIntoGrow(REBGRW * grow, void * opaque, const void *p, ...) {
+    RL_rebEnterApi_internal();
+    va_list va; va_start(va, p);
+    REBVAL *v = RL_rebValue(0, p, &va);
+    return Spell_Into_Grow(v, grow, opaque);
+}
+
+RL_API size_t rebBytesIntoGrow(REBGRW * grow, void * opaque, const void *p, ...) {
+    RL_rebEnterApi_internal();
+    va_list va; va_start(va, p);
+    REBVAL *v = RL_rebValue(0, p, &va);
+    return Bytes_Into_Grow(v, grow, opaque);
+}
+
+RL_API size_t rebSpellIntoGrowArray(REBGRW * grow, void * opaque, const void * const * items, size_t n) {
+    RL_rebEnterApi_internal();
+    SHIM_FEED feed; const void *p = Init_Array_Feed(&feed, items, n);
+    REBVAL *v = RL_rebValue(0, p, &feed.va);
+    Drop_Feed(&feed);
+    return Spell_Into_Grow(v, grow, opaque);
+}
+
+RL_API size_t rebBytesIntoGrowArray(REBGRW * grow, void * opaque, const void * const * items, size_t n) {
+    RL_rebEnterApi_internal();
+    SHIM_FEED feed; const void *p = Init_Array_Feed(&feed, items, n);
+    REBVAL *v = RL_rebValue(0, p, &feed.va);
+    Drop_Feed(&feed);
+    return Bytes_Into_Grow(v, grow, opaque);
+}
+
+
+//
+// Views
+//
+// AS BINARY! of a TEXT! aliases the string's UTF-8 storage rather than
+// copying it, so both kinds of view are read through a BINARY!.
+//
+// A series is pinned once however many views it has, so that closing them
+// out of order can't unprotect it under one still open.  The pins are
+// keyed by the series' head, which can't move while it's protected, and
+// only used on the thread in the interpreter, so they aren't locked.  A
+// handful of views is open at a time, so they're searched linearly.
+//
+
+struct shim_pin {
+    const unsigned char *head;
+    size_t count;
+    bool was_protected;
+};
+
+static void Drop_Pins(void) {
+    free(Shim_State->pins);
+    Shim_State->pins = NULL;
+    Shim_State->pins_count = Shim_State->pins_capacity = 0;
+}
+
+static SHIM_PIN *Find_Pin(const unsigned char *head) {
+    SHIM_STATE *state = Shim_State;
+    for (size_t i = 0; i < state->pins_count; ++i)
+        if (state->pins[i].head == head)
+            return &state->pins[i];
+    return NULL;
+}
+
+RL_API bool rebOpenView(REBVIEW * view, const REBVAL * v) {
+    RL_rebEnterApi_internal();
+
+    if (Did_Internal("text?", v, rebEND))
+        view->is_text = true;
+    else if (Did_Internal("binary?", v, rebEND))
+        view->is_text = false;
+    else
+        return false;
+
+    view->pinned = Value_Internal("as binary!", v, rebEND);
+    view->head = RL_rebBinaryHead_internal(view->pinned);
+
+    SHIM_PIN *pin = Find_Pin(view->head);
+    if (pin)
+        ++pin->count;
+    else {
+        SHIM_STATE *state = Shim_State;
+        if (state->pins_count == state->pins_capacity) {
+            size_t capacity = state->pins_capacity == 0
+                ? 8
+                : state->pins_capacity * 2;
+            SHIM_PIN *pins = (SHIM_PIN*)realloc(
+                state->pins, capacity * sizeof(SHIM_PIN)
+            );
+            if (pins == NULL) {
+                RL_rebRelease(view->pinned);
+                RL_rebFail_OS(ENOMEM);
+            }
+            state->pins = pins;
+            state->pins_capacity = capacity;
+        }
+        bool was_protected = Did_Internal("protected?", view->pinned, rebEND);
+        if (!was_protected)
+            Elide_Internal("protect", view->pinned, rebEND);
+
+        pin = &state->pins[state->pins_count++];
+        pin->head = view->head;
+        pin->count = 1;
+        pin->was_protected = was_protected;
+    }
+
+    view->data = RL_rebBinaryAt_internal(view->pinned);
+    view->size = RL_rebBinarySizeAt_internal(view->pinned);
+    return true;
+}
+
+RL_API void rebCloseView(REBVIEW * view) {
+    RL_rebEnterApi_internal();
+
+    SHIM_PIN *pin = Find_Pin(view->head);
+    assert(pin != NULL);
+    if (--pin->count == 0) {
+        bool was_protected = pin->was_protected;
+        *pin = Shim_State->pins[--Shim_State->pins_count];
+        if (!was_protected)
+            Elide_Internal("unprotect", view->pinned, rebEND);
+    }
+    RL_rebRelease(view->pinned);
+    view->pinned = NULL;
+    view->head = NULL;
+    view->data = NULL;
+    view->size = 0;
+}
+
+
+//
+// Foreign handles
+//
+// Each handle gets a record of its owner, and the record is what the
+// handle's data pointer points at, so the cleaner (which only gets the
+// handle) finds it in O(1), and handles never share one.  The records
+// alive are also kept in a set, open-addressed by record address, so
+// rebHandleBytes() can tell a HANDLE! made here from one made by the core
+// (whose data it can't know the shape of) without dereferencing anything.
+// The set is in the SHIM_STATE of the interpreter, which is the one
+// entered when its GC runs the cleaner, and it's locked: the GC of the
+// linked interpreter runs on whichever thread happens to be calling in.
+//
+// The API has no accessor for a HANDLE!'s data, so it's read from the
+// cell: the core lays one out as a header word and an "extra" word, then
+// two payload words, which for a HANDLE! are its data pointer and length.
+// Copies of a handle with a cleaner carry the same payload as the
+// canonical cell the cleaner is called with.  That layout is checked
+// against a handle made for the purpose before any are read, so a core
+// that lays cells out some other way fails instead of giving garbage.
+//
+
+struct shim_owner {
+    const void *data;
+    size_t size;
+    REBDROP *drop;
+    void *opaque;
+};
+
+inline static size_t Owner_Hash(SHIM_STATE *state, const SHIM_OWNER *owner) {
+    uintptr_t h = (uintptr_t)owner >> 4;  // malloc()'d, so aligned
+    return (size_t)(h * (uintptr_t)0x9E3779B97F4A7C15ull) & state->owners_mask;
+}
+
+static void Insert_Owner(SHIM_STATE *state, SHIM_OWNER *owner) {
+    size_t slot = Owner_Hash(state, owner);
+    while (state->owners[slot] != NULL)
+        slot = (slot + 1) & state->owners_mask;
+    state->owners[slot] = owner;
+    ++state->owners_count;
+}
+
+// Room for one more, keeping the set at most half full.
+//
+static bool Reserve_Owner(SHIM_STATE *state) {
+    if (state->owners != NULL && (state->owners_count + 1) * 2 <= state->owners_mask + 1)
+        return true;
+
+    size_t size = state->owners == NULL ? 64 : (state->owners_mask + 1) * 2;
+    SHIM_OWNER **old = state->owners;
+    size_t old_size = old == NULL ? 0 : state->owners_mask + 1;
+    SHIM_OWNER **owners = (SHIM_OWNER**)calloc(size, sizeof(SHIM_OWNER*));
+    if (owners == NULL)
+        return false;
+
+    state->owners = owners;
+    state->owners_mask = size - 1;
+    state->owners_count = 0;
+    for (size_t i = 0; i < old_size; ++i)
+        if (old[i] != NULL)
+            Insert_Owner(state, old[i]);
+    free(old);
+    return true;
+}
+
+static bool Find_Owner(SHIM_STATE *state, const SHIM_OWNER *owner, size_t *slot_out) {
+    if (state->owners == NULL)
+        return false;
+    size_t slot = Owner_Hash(state, owner);
+    while (state->owners[slot] != NULL) {
+        if (state->owners[slot] == owner) {
+            *slot_out = slot;
+            return true;
+        }
+        slot = (slot + 1) & state->owners_mask;
+    }
+    return false;
+}
+
+static void Remove_Owner(SHIM_STATE *state, size_t slot) {
+    // Backward-shift deletion, as for arena indexes.
+    //
+    size_t hole = slot;
+    state->owners[hole] = NULL;
+    --state->owners_count;
+    while (true) {
+        slot = (slot + 1) & state->owners_mask;
+        if (state->owners[slot] == NULL)
+            return;
+        size_t home = Owner_Hash(state, state->owners[slot]);
+        if (((slot - home) & state->owners_mask) >= ((slot - hole) & state->owners_mask)) {
+            state->owners[hole] = state->owners[slot];
+            state->owners[slot] = NULL;
+            hole = slot;
+        }
+    }
+}
+
+// After a shutdown, whose GC has run the cleaners of any handles left, so
+// all that can remain are records of handles that failed to be made.
+//
+static void Drop_Owners(void) {
+    SHIM_STATE *state = Shim_State;
+    Shim_Lock(&state->owners_lock);
+    if (state->owners != NULL)
+        for (size_t i = 0; i <= state->owners_mask; ++i)
+            free(state->owners[i]);
+    free(state->owners);
+    state->owners = NULL;
+    state->owners_count = state->owners_mask = 0;
+    state->handle_layout_checked = false;
+    Shim_Unlock(&state->owners_lock);
+}
+
+static const void *Handle_Payload(const REBVAL *v, size_t *size_out) {
+    const uintptr_t *cell = (const uintptr_t*)v;
+    if (size_out)
+        *size_out = (size_t)cell[3];
+    return (const void*)cell[2];
+}
+
+static void Check_Handle_Layout(void) {
+    if (Shim_State->handle_layout_checked)
+        return;
+
+    static const char probe[1] = { 0 };
+    const size_t probe_size = 0x5EED;
+    REBVAL *handle = RL_rebHandle((void*)probe, probe_size, NULL);
+    size_t size;
+    const void *data = Handle_Payload(handle, &size);
+    RL_rebRelease(handle);
+
+    if (data != probe || size != probe_size)
+        Elide_Internal(
+            "fail {HANDLE! cells aren't laid out as the shim expects}",
+            rebEND
+        );
+    Shim_State->handle_layout_checked = true;
+}
+
+static void Foreign_Handle_Cleaner(const REBVAL *v) {
+    SHIM_OWNER *owner = (SHIM_OWNER*)Handle_Payload(v, NULL);
+    SHIM_STATE *state = Shim_State;
+
+    Shim_Lock(&state->owners_lock);
+    size_t slot;
+    if (Find_Owner(state, owner, &slot))
+        Remove_Owner(state, slot);
+    else
+        assert(!"foreign handle cleaned up with no owner");
+    Shim_Unlock(&state->owners_lock);
+
+    if (owner->drop)
+        owner->drop(owner->opaque);
+    free(owner);
+}
+
+RL_API REBVAL * rebForeignHandle(const void * data, size_t size, REBDROP * drop, void * opaque) {
+    RL_rebEnterApi_internal();
+    Check_Handle_Layout();
+
+    // The record goes in first, so the handle can be made unlocked (making
+    // it may set off a GC, which may clean up others).  If making it fails,
+    // which only running out of memory does, the record stays behind until
+    // shutdown with its owner never dropped, as the caller has given it up
+    // anyway.
+    //
+    SHIM_OWNER *owner = (SHIM_OWNER*)malloc(sizeof(SHIM_OWNER));
+    if (owner == NULL)
+        RL_rebFail_OS(ENOMEM);
+    owner->data = data;
+    owner->size = size;
+    owner->drop = drop;
+    owner->opaque = opaque;
+
+    SHIM_STATE *state = Shim_State;
+    Shim_Lock(&state->owners_lock);
+    bool reserved = Reserve_Owner(state);
+    if (reserved)
+        Insert_Owner(state, owner);
+    Shim_Unlock(&state->owners_lock);  // not held through a failure
+    if (!reserved) {
+        free(owner);
+        RL_rebFail_OS(ENOMEM);
+    }
+
+    return Track(RL_rebHandle(owner, size, &Foreign_Handle_Cleaner));
+}
+
+RL_API const unsigned char * rebHandleBytes(size_t * size_out, const REBVAL * handle) {
+    RL_rebEnterApi_internal();
+    if (!Did_Internal("handle?", handle, rebEND))
+        return NULL;
+    Check_Handle_Layout();
+
+    // The handle is held by the caller, so its record can't be cleaned up
+    // once it's been found.
+    //
+    const SHIM_OWNER *owner = (const SHIM_OWNER*)Handle_Payload(handle, NULL);
+    SHIM_STATE *state = Shim_State;
+    size_t slot;
+    Shim_Lock(&state->owners_lock);
+    bool foreign = Find_Owner(state, owner, &slot);
+    Shim_Unlock(&state->owners_lock);
+    if (!foreign)
+        return NULL;
+
+    if (size_out)
+        *size_out = owner->size;
+    return (const unsigned char*)owner->data;
+}
+
+
+//
+// Script bundles
+//
+// A bundle is SHIM_BUNDLE_MAGIC, then for each script its size as a
+// uint32_t and its bytes.  All of it is checked before anything runs, and
+// the texts are made before any of them run, so the bundle can be unmapped
+// up front instead of leaking if a script fails.
+//
+
+#define SHIM_BUNDLE_MAGIC "RENCBDL1"
+#define SHIM_BUNDLE_MAGIC_SIZE 8
+
+static bool Copy_Into_Bundle(FILE *out, const char *file) {
+    FILE *in = fopen(file, "rb");
+    if (in == NULL)
+        return false;
+
+    bool ok = fseek(in, 0, SEEK_END) == 0;
+    long size = ok ? ftell(in) : -1;
+    ok = size >= 0 && (unsigned long)size <= UINT32_MAX
+        && fseek(in, 0, SEEK_SET) == 0;
+    if (ok) {
+        uint32_t size32 = (uint32_t)size;
+        ok = fwrite(&size32, sizeof(size32), 1, out) == 1;
+    }
+
+    char buf[16 * 1024];
+    while (ok && size > 0) {
+        size_t n = fread(buf, 1, sizeof(buf), in);
+        if (n == 0 || fwrite(buf, 1, n, out) != n)
+            ok = false;
+        size -= (long)n;
+    }
+    fclose(in);
+    return ok;
+}
+
+RL_API bool rebSaveScriptBundle(const char * path, const char * const * files, size_t n) {
+    FILE *out = fopen(path, "wb");
+    if (out == NULL)
+        return false;
+
+    bool ok = fwrite(SHIM_BUNDLE_MAGIC, SHIM_BUNDLE_MAGIC_SIZE, 1, out) == 1;
+    size_t i;
+    for (i = 0; ok && i < n; ++i)
+        ok = Copy_Into_Bundle(out, files[i]);
+
+    if (fclose(out) != 0)
+        ok = false;
+    if (!ok)
+        remove(path);  // no half-written bundles
+    return ok;
+}
+
+static const unsigned char *Map_Bundle(const char *path, size_t *size_out) {
+  #if defined(WIN32)
+    FILE *in = fopen(path, "rb");
+    if (in == NULL)
+        return NULL;
+    unsigned char *bundle = NULL;
+    long size = -1;
+    if (fseek(in, 0, SEEK_END) == 0 && (size = ftell(in)) > 0)
+        bundle = (unsigned char*)malloc((size_t)size);
+    if (
+        bundle != NULL
+        && (
+            fseek(in, 0, SEEK_SET) != 0
+            || fread(bundle, 1, (size_t)size, in) != (size_t)size
+        )
+    ){
+        free(bundle);
+        bundle = NULL;
+    }
+    fclose(in);
+    *size_out = (size_t)size;
+    return bundle;
+  #else
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return NULL;
+    struct stat st;
+    void *bundle = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && st.st_size > 0)
+        bundle = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);  // the mapping stays
+    if (bundle == MAP_FAILED)
+        return NULL;
+    *size_out = (size_t)st.st_size;
+    return (const unsigned char*)bundle;
+  #endif
+}
+
+static void Unmap_Bundle(const unsigned char *bundle, size_t size) {
+  #if defined(WIN32)
+    (void)size;
+    free((void*)bundle);
+  #else
+    munmap((void*)bundle, size);
+  #endif
+}
+
+RL_API bool rebStartupWithScripts(const char * path) {
+    size_t size = 0;
+    const unsigned char *bundle = Map_Bundle(path, &size);
+
+    RL_rebStartup();
+    if (bundle == NULL)
+        return false;
+
+    const unsigned char *tail = bundle + size;
+    const unsigned char *at = bundle + SHIM_BUNDLE_MAGIC_SIZE;
+    bool ok = size >= SHIM_BUNDLE_MAGIC_SIZE
+        && memcmp(bundle, SHIM_BUNDLE_MAGIC, SHIM_BUNDLE_MAGIC_SIZE) == 0;
+    while (ok && at != tail) {
+        uint32_t len;
+        if ((size_t)(tail - at) < sizeof(len)) {
+            ok = false;
+            break;
+        }
+        memcpy(&len, at, sizeof(len));
+        at += sizeof(len);
+        if ((size_t)(tail - at) < len) {
+            ok = false;
+            break;
+        }
+        at += len;
+    }
+    if (!ok) {
+        Unmap_Bundle(bundle, size);
+        return false;
+    }
+
+    REBVAL *scripts = Value_Internal("copy []", rebEND);
+    for (at = bundle + SHIM_BUNDLE_MAGIC_SIZE; at != tail; ) {
+        uint32_t len;
+        memcpy(&len, at, sizeof(len));
+        at += sizeof(len);
+        REBVAL *text = RL_rebSizedText((const char*)at, len);
+        Elide_Internal("append", scripts, text, rebEND);
+        RL_rebRelease(text);
+        at += len;
+    }
+    Unmap_Bundle(bundle, size);
+
+    Elide_Internal("for-each script", scripts, "[do script]", rebEND);
+    RL_rebRelease(scripts);
+    return true;
+}
+
+
+//
+// Checkpoints
+//
+// The record is a shallow copy of the user context, as an OBJECT!: the
+// very values the words had, so a reset can tell which words were set
+// since by SAME?, and puts back the same series (and functions, with
+// whatever series they hold) rather than copies.  Words can't be taken
+// out of a context, so the ones added since are unset.
+//
+
+static void Drop_Checkpoint(void) {
+    if (Shim_State->checkpoint == NULL)
+        return;
+    RL_rebRelease(Shim_State->checkpoint);
+    Shim_State->checkpoint = NULL;
+}
+
+RL_API void rebCheckpoint(void) {
+    RL_rebEnterApi_internal();
+    Drop_Checkpoint();
+    Shim_State->checkpoint = Value_Internal(
+        "copy system/contexts/user", rebEND
+    );
+}
+
+RL_API bool rebResetToCheckpoint(void) {
+    RL_rebEnterApi_internal();
+    if (Shim_State->checkpoint == NULL)
+        return false;
+
+    const REBVAL *saved = Shim_State->checkpoint;
+    Elide_Internal(
+        "for-each key system/contexts/user [",
+            "if not in", saved, "key [unset in system/contexts/user key]",
+        "]",
+        rebEND
+    );
+    Elide_Internal(
+        "for-each [key val]", saved, "[",
+            "if not same? get/any in system/contexts/user key get/any 'val [",
+                "set/any in system/contexts/user key get/any 'val",
+            "]",
+        "]",
+        rebEND
+    );
+
+    Elide_Internal("recycle", rebEND);
+    return true;
+}
+
+
+//
+// Continuations
+//
+// The feed is loaded by evaluating it wrapped in brackets, which gives
+// its code as a BLOCK! (bound as rebValue() would bind it).  Each step is
+// an EVALUATE/SET of the next expression, into a word of a private object.
+//
+
+struct rebol_continuation {
+    REBVAL *position;  // the rest of the code
+    REBVAL *slot;  // OBJECT! whose `result` has the last expression's value
+    bool done;
+    bool failed;  // `result` is then stale, from the expression before
+};
+
+RL_API REBCONT * rebOpenContinuation(const void * p, ...) {
+    RL_rebEnterApi_internal();
+    va_list va; va_start(va, p);
+
+    size_t n = 0;
+    va_list scan;
+    va_copy(scan, va);
+    const void *item = p;
+    while (!Is_Feed_End(item)) {
+        ++n;
+        item = va_arg(scan, const void*);
+    }
+    va_end(scan);
+
+    const void *stack[SHIM_FEED_STACK_ITEMS];
+    const void **items = n + 2 <= SHIM_FEED_STACK_ITEMS
+        ? stack
+        : (const void**)RL_rebMalloc((n + 2) * sizeof(const void*));
+
+    size_t i;
+    items[0] = "[";
+    if (n != 0)
+        items[1] = p;
+    for (i = 1; i < n; ++i)
+        items[i + 1] = va_arg(va, const void*);
+    items[n + 1] = "]";
+    va_end(va);
+
+    SHIM_FEED feed;
+    const void *first = Init_Array_Feed(&feed, items, n + 2);
+    REBVAL *code = RL_rebValue(0, first, &feed.va);
+    Drop_Feed(&feed);
+    if (items != stack)
+        RL_rebFree(items);
+
+    REBCONT *cont = (REBCONT*)malloc(sizeof(REBCONT));  // outlives the call
+    if (cont == NULL) {
+        RL_rebRelease(code);
+        RL_rebFail_OS(ENOMEM);
+    }
+    cont->position = code;
+    cont->slot = Value_Internal("make object! [result: null]", rebEND);
+    cont->done = false;
+    cont->failed = false;
+    return cont;
+}
+
+RL_API bool rebResume(REBCONT * cont, uintptr_t budget) {
+    RL_rebEnterApi_internal();
+    if (cont->done)
+        return true;
+
+    uintptr_t start = RL_rebTick();
+    uintptr_t steps = 0;
+    do {
+        if (Did_Internal("tail?", cont->position, rebEND)) {
+            cont->done = true;
+            return true;
+        }
+
+        cont->done = cont->failed = true;  // stay so if the step fails
+        REBVAL *next = Value_Internal(
+            "evaluate/set", cont->position, "in", cont->slot, "'result",
+            rebEND
+        );
+        cont->failed = false;
+        RL_rebRelease(cont->position);
+        cont->position = next;
+        if (next == NULL)  // EVALUATE gives null at the end
+            return true;
+        cont->done = false;
+
+        ++steps;
+        uintptr_t tick = RL_rebTick();
+        if ((tick == 0 ? steps : tick - start) >= budget)
+            break;
+    } while (true);
+
+    cont->done = Did_Internal("tail?", cont->position, rebEND);
+    return cont->done;
+}
+
+RL_API REBVAL * rebContinuationResult(REBCONT * cont) {
+    RL_rebEnterApi_internal();
+    if (!cont->done || cont->failed)
+        return NULL;
+    return Track(Value_Internal("get/any in", cont->slot, "'result", rebEND));
+}
+
+RL_API void rebCloseContinuation(REBCONT * cont) {
+    RL_rebEnterApi_internal();
+    if (cont == NULL)
+        return;
+    if (cont->position)
+        RL_rebRelease(cont->position);
+    RL_rebRelease(cont->slot);
+    free(cont);
+}
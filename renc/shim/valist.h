@@ -0,0 +1,488 @@
+/*
+ * Prototypes for the libRebol shim in %valist.c
+ *
+ * The RL_rebXXX() entry points exported by the interpreter take their
+ * variadic input as a `va_list*`, which can't be produced from Rust (or
+ * any other FFI client that can't do C varargs).  The shim exports the
+ * plain rebXXX() names as real functions that do the va_start() and the
+ * API entry on the caller's behalf.  This header is what %wrapper.h
+ * feeds to bindgen, and what the shim itself is checked against.
+ */
+#ifndef REBOL_SHIM_VALIST_H
+#define REBOL_SHIM_VALIST_H
+
+/*
+ * %rebol.h has no include guard, so it must already have been included
+ * (with REBOL_DISABLE_ACCESSOR_MACROS, since the names below are real
+ * functions and not the rebXXX_inline() macros).
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * SIZED FRAGMENTS
+ *
+ * Feeds take UTF-8 fragments as NUL-terminated strings.  A REBFRG can be
+ * passed in their place to give a fragment by pointer and size instead,
+ * e.g. a slice of a larger buffer, which needs no terminator.  It is
+ * accepted by the Array entry points (rebValueArray() and the like, see
+ * ARRAY FEEDS), and only has to live for the duration of the call:
+ *
+ *     const void *items[] = { rebSizedFragment(script + offset, len) };
+ *     rebValueArray(items, 1);
+ *
+ * The variadic entry points hand their va_list straight to the core,
+ * which doesn't know REBFRGs, so they must not be given one.
+ *
+ * The first header byte can't start valid UTF-8, a Rebol value or
+ * rebEND, which is how the shim tells it apart.  Fragments are staged as
+ * terminated copies by the shim before the core sees the feed, since the
+ * core can only scan NUL-terminated text.
+ */
+#define REBOL_SIZED_FRAGMENT_BYTE 0xF8
+
+typedef struct rebol_sized_fragment {
+    unsigned char header[8];  /* header[0] is REBOL_SIZED_FRAGMENT_BYTE */
+    const char *utf8;
+    size_t size;
+} REBFRG;
+
+#if defined(__cplusplus)
+    inline static const void *rebSizedFragment_inline(
+        const REBFRG &frag
+    ){
+        return &frag;
+    }
+    #define rebSizedFragment(utf8, size) \
+        rebSizedFragment_inline( \
+            REBFRG{{REBOL_SIZED_FRAGMENT_BYTE}, (utf8), (size)} \
+        )
+#else
+    #define rebSizedFragment(utf8, size) \
+        ((const void*)&(const REBFRG){ \
+            {REBOL_SIZED_FRAGMENT_BYTE}, (utf8), (size) \
+        })
+#endif
+
+RL_API void * rebMalloc(size_t size);
+RL_API void * rebRealloc(void * ptr, size_t new_size);
+RL_API void rebFree(void * ptr);
+RL_API REBVAL * rebRepossess(void * ptr, size_t size);
+RL_API void rebStartup(void);
+RL_API void rebShutdown(bool clean);
+RL_API uintptr_t rebTick(void);
+RL_API REBVAL * rebVoid(void);
+RL_API REBVAL * rebBlank(void);
+RL_API REBVAL * rebLogic(bool logic);
+RL_API REBVAL * rebChar(uint32_t codepoint);
+RL_API REBVAL * rebInteger(int64_t i);
+RL_API REBVAL * rebDecimal(double dec);
+RL_API REBVAL * rebSizedBinary(const void * bytes, size_t size);
+RL_API REBVAL * rebUninitializedBinary_internal(size_t size);
+RL_API unsigned char * rebBinaryHead_internal(const REBVAL * binary);
+RL_API unsigned char * rebBinaryAt_internal(const REBVAL * binary);
+RL_API unsigned int rebBinarySizeAt_internal(const REBVAL * binary);
+RL_API REBVAL * rebSizedText(const char * utf8, size_t size);
+RL_API REBVAL * rebText(const char * utf8);
+RL_API REBVAL * rebLengthedTextWide(const REBWCHAR * wstr, unsigned int num_chars);
+RL_API REBVAL * rebTextWide(const REBWCHAR * wstr);
+RL_API REBVAL * rebHandle(void * data, size_t length, CLEANUP_CFUNC * cleaner);
+RL_API const void * rebArgR(const void *p, ...);
+RL_API const void * rebArgRQ(const void *p, ...);
+RL_API REBVAL * rebArg(const void *p, ...);
+RL_API REBVAL * rebArgQ(const void *p, ...);
+RL_API REBVAL * rebValue(const void *p, ...);
+RL_API REBVAL * rebValueQ(const void *p, ...);
+RL_API REBVAL * rebQuote(const void *p, ...);
+RL_API REBVAL * rebQuoteQ(const void *p, ...);
+RL_API void rebElide(const void *p, ...);
+RL_API void rebElideQ(const void *p, ...);
+RL_API ATTRIBUTE_NO_RETURN void rebJumps(const void *p, ...);
+RL_API ATTRIBUTE_NO_RETURN void rebJumpsQ(const void *p, ...);
+RL_API bool rebDid(const void *p, ...);
+RL_API bool rebDidQ(const void *p, ...);
+RL_API bool rebNot(const void *p, ...);
+RL_API bool rebNotQ(const void *p, ...);
+RL_API intptr_t rebUnbox(const void *p, ...);
+RL_API intptr_t rebUnboxQ(const void *p, ...);
+RL_API intptr_t rebUnbox0(const void * p);
+RL_API intptr_t rebUnboxInteger(const void *p, ...);
+RL_API intptr_t rebUnboxIntegerQ(const void *p, ...);
+RL_API intptr_t rebUnboxInteger0(const void * p);
+RL_API double rebUnboxDecimal(const void *p, ...);
+RL_API double rebUnboxDecimalQ(const void *p, ...);
+RL_API uint32_t rebUnboxChar(const void *p, ...);
+RL_API uint32_t rebUnboxCharQ(const void *p, ...);
+RL_API size_t rebSpellInto(char * buf, size_t buf_size, const void *p, ...);
+RL_API size_t rebSpellIntoQ(char * buf, size_t buf_size, const void *p, ...);
+RL_API char * rebSpell(const void *p, ...);
+RL_API char * rebSpellQ(const void *p, ...);
+RL_API unsigned int rebSpellIntoWide(REBWCHAR * buf, unsigned int buf_chars, const void *p, ...);
+RL_API unsigned int rebSpellIntoWideQ(REBWCHAR * buf, unsigned int buf_chars, const void *p, ...);
+RL_API REBWCHAR * rebSpellWide(const void *p, ...);
+RL_API REBWCHAR * rebSpellWideQ(const void *p, ...);
+RL_API size_t rebBytesInto(unsigned char * buf, size_t buf_size, const void *p, ...);
+RL_API size_t rebBytesIntoQ(unsigned char * buf, size_t buf_size, const void *p, ...);
+RL_API unsigned char * rebBytes(size_t * size_out, const void *p, ...);
+RL_API unsigned char * rebBytesQ(size_t * size_out, const void *p, ...);
+RL_API REBVAL * rebRescue(REBDNG * dangerous, void * opaque);
+RL_API REBVAL * rebRescueWith(REBDNG * dangerous, REBRSC * rescuer, void * opaque);
+RL_API void rebHalt(void);
+RL_API const void * rebQUOTING(const void *p, ...);
+RL_API const void * rebQUOTINGQ(const void *p, ...);
+RL_API const void * rebUNQUOTING(const void *p, ...);
+RL_API const void * rebUNQUOTINGQ(const void *p, ...);
+RL_API const void * rebRELEASING(REBVAL * v);
+RL_API REBVAL * rebManage(REBVAL * v);
+RL_API void rebUnmanage(void * p);
+RL_API void rebRelease(const REBVAL * v);
+RL_API void * rebDeflateAlloc(size_t * out_len, const void * input, size_t in_len);
+RL_API void * rebZdeflateAlloc(size_t * out_len, const void * input, size_t in_len);
+RL_API void * rebGzipAlloc(size_t * out_len, const void * input, size_t in_len);
+RL_API void * rebInflateAlloc(size_t * len_out, const void * input, size_t len_in, int max);
+RL_API void * rebZinflateAlloc(size_t * len_out, const void * input, size_t len_in, int max);
+RL_API void * rebGunzipAlloc(size_t * len_out, const void * input, size_t len_in, int max);
+RL_API void * rebDeflateDetectAlloc(size_t * len_out, const void * input, size_t len_in, int max);
+RL_API ATTRIBUTE_NO_RETURN void rebFail_OS(int errnum);
+
+/*
+ * Which implementation the rebDeflateAlloc() family above runs on, chosen
+ * when the shim is built: "core" (the interpreter's own zlib), "zlib" or
+ * "libdeflate".  The formats are the same whichever it is.
+ */
+RL_API const char * rebDeflateBackend(void);
+
+/*
+ * rebDeflateDetectAlloc() that can be told more, to allocate its output
+ * once instead of growing it.  `size_hint` is the expected decompressed
+ * size (0 if not known; gzip's is then read from its trailer).  If
+ * `*format` is -1, the envelope is detected from the header bytes and
+ * written back as REB_CODEC_DEFLATE, REB_CODEC_ZLIB or REB_CODEC_GZIP
+ * (see %codec.h), so later calls for the same source can pass it and skip
+ * detection; any other value fails.  This and rebDeflateDetectAlloc() run
+ * on the shim's backend, even if that's the core's.
+ */
+RL_API void * rebDecompressAlloc(size_t * len_out, int * format, const void * input, size_t len_in, int max, size_t size_hint);
+
+/*
+ * ARRAY FEEDS
+ *
+ * Same evaluations as the variadic entry points above, but the feed is
+ * given as `n` items in an array instead of as C varargs.  Items are what
+ * would have been passed variadically (UTF-8 fragments, REBVAL*, rebQ()
+ * and rebR() instructions...), and no rebEND is needed--the length is the
+ * terminator.  This lets feeds be built up at runtime by the caller.
+ */
+RL_API REBVAL * rebValueArray(const void * const * items, size_t n);
+RL_API REBVAL * rebValueArrayQ(const void * const * items, size_t n);
+RL_API REBVAL * rebQuoteArray(const void * const * items, size_t n);
+RL_API REBVAL * rebQuoteArrayQ(const void * const * items, size_t n);
+RL_API void rebElideArray(const void * const * items, size_t n);
+RL_API void rebElideArrayQ(const void * const * items, size_t n);
+RL_API bool rebDidArray(const void * const * items, size_t n);
+RL_API bool rebDidArrayQ(const void * const * items, size_t n);
+RL_API bool rebNotArray(const void * const * items, size_t n);
+RL_API bool rebNotArrayQ(const void * const * items, size_t n);
+RL_API intptr_t rebUnboxArray(const void * const * items, size_t n);
+RL_API intptr_t rebUnboxArrayQ(const void * const * items, size_t n);
+RL_API intptr_t rebUnboxIntegerArray(const void * const * items, size_t n);
+RL_API intptr_t rebUnboxIntegerArrayQ(const void * const * items, size_t n);
+RL_API double rebUnboxDecimalArray(const void * const * items, size_t n);
+RL_API double rebUnboxDecimalArrayQ(const void * const * items, size_t n);
+RL_API uint32_t rebUnboxCharArray(const void * const * items, size_t n);
+RL_API uint32_t rebUnboxCharArrayQ(const void * const * items, size_t n);
+RL_API size_t rebSpellIntoArray(char * buf, size_t buf_size, const void * const * items, size_t n);
+RL_API size_t rebSpellIntoArrayQ(char * buf, size_t buf_size, const void * const * items, size_t n);
+RL_API char * rebSpellArray(const void * const * items, size_t n);
+RL_API char * rebSpellArrayQ(const void * const * items, size_t n);
+RL_API size_t rebBytesIntoArray(unsigned char * buf, size_t buf_size, const void * const * items, size_t n);
+RL_API size_t rebBytesIntoArrayQ(unsigned char * buf, size_t buf_size, const void * const * items, size_t n);
+RL_API unsigned char * rebBytesArray(size_t * size_out, const void * const * items, size_t n);
+RL_API unsigned char * rebBytesArrayQ(size_t * size_out, const void * const * items, size_t n);
+
+/*
+ * PREPARED EVALUATION
+ *
+ * rebPrepare() takes the UTF-8 fragments of a feed that has one spliced
+ * value ("slot") between each pair of fragments, e.g. {"1 +", ""} for the
+ * shape of `rebValue("1 +", one)`.  It scans and binds them once, giving
+ * back a handle (an ACTION! taking one argument per slot) to be released
+ * with rebRelease().  Running it with the slot values then only costs an
+ * evaluation: no scanning or binding is redone.
+ *
+ * The fragments become the body of a FUNC, and the slots its arguments,
+ * so the result isn't always what rebValue() with the same feed gives:
+ *
+ * - A slot is a WORD! for the argument, and is only replaced by its value
+ *   where that word gets evaluated.  So `"reduce [", slot, "]"` gives a
+ *   block of the value, but `"[", slot, "]"` gives `[rebslot-1]`.
+ *
+ * - A RETURN in a fragment returns from the prepared function (giving
+ *   the result of the run), not from any function the caller is in.
+ *
+ * - SET-WORD!s in the fragments follow FUNC's rules: they are locals of
+ *   the prepared function, not words of the user context.
+ *
+ * Fragments should not refer to words named `rebslot-N`, which are used
+ * for the slots.
+ */
+RL_API REBVAL * rebPrepare(const char * const * fragments, size_t num_fragments);
+RL_API REBVAL * rebRunPrepared(const REBVAL * prepared, const REBVAL * const * args, size_t num_args);
+RL_API void rebElidePrepared(const REBVAL * prepared, const REBVAL * const * args, size_t num_args);
+
+/*
+ * API SESSIONS
+ *
+ * Every entry point above starts with RL_rebEnterApi_internal().  Code
+ * making many calls in a row from one thread can instead bracket them in
+ * rebEnterSession()/rebLeaveSession() (which nest) and use the _entered
+ * variants below, which skip the per-call entry.  Debug builds of the
+ * shim check that an _entered call is made inside a session on the
+ * calling thread.
+ */
+RL_API void rebEnterSession(void);
+RL_API void rebLeaveSession(void);
+
+RL_API REBVAL * rebVoid_entered(void);
+RL_API REBVAL * rebBlank_entered(void);
+RL_API REBVAL * rebLogic_entered(bool logic);
+RL_API REBVAL * rebChar_entered(uint32_t codepoint);
+RL_API REBVAL * rebInteger_entered(int64_t i);
+RL_API REBVAL * rebDecimal_entered(double dec);
+RL_API REBVAL * rebSizedBinary_entered(const void * bytes, size_t size);
+RL_API REBVAL * rebSizedText_entered(const char * utf8, size_t size);
+RL_API REBVAL * rebText_entered(const char * utf8);
+RL_API REBVAL * rebValue_entered(const void *p, ...);
+RL_API void rebElide_entered(const void *p, ...);
+RL_API bool rebDid_entered(const void *p, ...);
+RL_API intptr_t rebUnboxInteger_entered(const void *p, ...);
+RL_API intptr_t rebUnbox0_entered(const void * p);
+RL_API intptr_t rebUnboxInteger0_entered(const void * p);
+RL_API void rebRelease_entered(const REBVAL * v);
+RL_API REBVAL * rebValueArray_entered(const void * const * items, size_t n);
+RL_API void rebElideArray_entered(const void * const * items, size_t n);
+RL_API REBVAL * rebRunPrepared_entered(const REBVAL * prepared, const REBVAL * const * args, size_t num_args);
+
+/*
+ * HANDLE ARENAS
+ *
+ * While an arena is open, every API handle the shim returns on that
+ * thread (rebInteger(), rebText(), rebValue()...) is recorded, and
+ * rebCloseArena() releases all of them in one call.  Arenas nest: close
+ * with the mark that the matching rebOpenArena() returned.  Each instance
+ * (see INSTANCES) has arenas of its own, apart from the thread's, so only
+ * close an arena with the instance it was opened with entered.
+ *
+ * Handles in an arena can still be rebRelease()'d, rebR()'d or
+ * rebManage()'d individually; they are dropped from the arena when they
+ * are.  rebUnarena() takes a handle out of the arena so it survives it.
+ *
+ * rebReleaseMany() releases a batch of handles with one API entry.
+ */
+RL_API size_t rebOpenArena(void);
+RL_API void rebCloseArena(size_t mark);
+RL_API REBVAL * rebUnarena(REBVAL * v);
+RL_API void rebReleaseMany(const REBVAL * const * v, size_t n);
+
+/*
+ * GROWABLE SPELL AND BYTES
+ *
+ * rebSpellInto() and rebBytesInto() evaluate their feed on each call, so
+ * sizing a buffer and then filling it evaluates twice, while rebSpell()
+ * and rebBytes() allocate every time.  These evaluate once, then ask the
+ * grow callback for a buffer of the exact size needed (for text that
+ * includes the '\0') and fill it.  A callback that keeps its buffer
+ * around and only reallocates when it's too small makes the steady state
+ * allocation-free.  If the callback returns NULL for a nonzero size, the
+ * call fails (as out of memory).
+ *
+ * Return the size of the spelling or binary (not counting the '\0').
+ */
+typedef void * (REBGRW)(void *opaque, size_t size);
+
+RL_API size_t rebSpellIntoGrow(REBGRW * grow, void * opaque, const void *p, ...);
+RL_API size_t rebBytesIntoGrow(REBGRW * grow, void * opaque, const void *p, ...);
+RL_API size_t rebSpellIntoGrowArray(REBGRW * grow, void * opaque, const void * const * items, size_t n);
+RL_API size_t rebBytesIntoGrowArray(REBGRW * grow, void * opaque, const void * const * items, size_t n);
+
+/*
+ * VIEWS
+ *
+ * rebOpenView() gives direct read access to the bytes of a TEXT! (its
+ * UTF-8) or BINARY!, from the value's position to its tail, without
+ * copying.  While any view of a series is open, the series is PROTECTed,
+ * so nothing can resize it (which is the only thing that moves series
+ * data; the GC doesn't) and `data` stays valid.  The view holds its own
+ * API handle, so the value can't be GC'd out from under it either.
+ *
+ * Views of one series are counted, so they may be closed in any order:
+ * the series is unprotected when the last one closes, and only if it
+ * wasn't protected when the first one opened.  The core has no hold that
+ * Rebol code can't lift, though, so the PROTECT is a user-visible one: if
+ * code run while a view is open UNPROTECTs the series and then resizes
+ * it, `data` dangles.  Callers must not run such code with views open.
+ *
+ * Returns false (and opens nothing) if the value isn't a TEXT! or a
+ * BINARY!.  Every view that was opened must be closed.
+ */
+typedef struct rebol_view {
+    const unsigned char *data;
+    size_t size;
+    bool is_text;
+    REBVAL *pinned;  /* BINARY! aliasing the data, protected */
+    const unsigned char *head;  /* identifies the series while pinned */
+} REBVIEW;
+
+RL_API bool rebOpenView(REBVIEW * view, const REBVAL * v);
+RL_API void rebCloseView(REBVIEW * view);
+
+/*
+ * FOREIGN HANDLES
+ *
+ * rebForeignHandle() wraps memory the caller owns (a buffer, an mmap'd
+ * region...) in a HANDLE! without copying it.  When the GC collects the
+ * handle, `drop(opaque)` is called so the owner can free it, on whichever
+ * thread the GC runs on.  The bytes must stay put and unchanged until
+ * then.
+ *
+ * rebHandleBytes() gives the data pointer and size of a HANDLE! made by
+ * rebForeignHandle(), or NULL if the value isn't one.  Other HANDLE!s'
+ * data may be anything, so it isn't given out.
+ */
+typedef void (REBDROP)(void *opaque);
+
+RL_API REBVAL * rebForeignHandle(const void * data, size_t size, REBDROP * drop, void * opaque);
+RL_API const unsigned char * rebHandleBytes(size_t * size_out, const REBVAL * handle);
+
+/*
+ * INSTANCES
+ *
+ * Independent interpreters in one process, e.g. one per worker thread so
+ * scripts run on every core at once.  The core keeps its state in
+ * globals, so each instance is a separate copy of libr3, loaded with
+ * dlmopen() into a link namespace of its own.  `path` is that library
+ * (NULL for "libr3.so", found the way dlopen() finds it).  The instance
+ * is started when it's created, and shut down when it's destroyed.
+ *
+ * rebEnterInstance() makes API calls on the calling thread go to
+ * `instance` (NULL for the libr3 the program is linked with), and gives
+ * back the one entered before, to enter again when done.  An instance
+ * must only be entered and destroyed on the thread that created it, and
+ * values, handles and rebMalloc() memory must not cross instances.  What
+ * the shim keeps for an interpreter--arenas, foreign handle owners, the
+ * checkpoint, cached codecs--is kept for each instance apart.
+ *
+ * Needs a shim built with SHIM_INSTANCES (Linux, glibc); without it, or if
+ * the library can't be loaded, rebCreateInstance() returns NULL and
+ * rebInstanceError() says why.  glibc has room for 15 extra namespaces,
+ * which caps the number of instances alive at once.  Each namespace has
+ * its own copy of libc too, so an instance's stdio is buffered apart from
+ * the program's.
+ */
+typedef struct rebol_instance REBINST;
+
+RL_API REBINST * rebCreateInstance(const char * path);
+RL_API void rebDestroyInstance(REBINST * instance);
+RL_API REBINST * rebEnterInstance(REBINST * instance);
+RL_API const char * rebInstanceError(void);
+
+/*
+ * SCRIPT BUNDLES
+ *
+ * The scripts an embedder preloads every time (e.g. its modules), gathered
+ * into one file so they aren't looked up and read one by one.  This is no
+ * boot image: the scripts still run on every startup.  Saving the booted
+ * state itself would need snapshot support in the core, as its heap is
+ * full of absolute pointers, and lives in libr3's globals and mallocs.
+ *
+ * rebSaveScriptBundle() writes the `n` script files to the bundle at
+ * `path`, in order.  rebStartupWithScripts() boots the interpreter,
+ * mmap()s the bundle and DOes its scripts in that order.  If the bundle
+ * can't be opened or isn't one, it returns false (with the interpreter
+ * booted, so the caller can fall back to loading the scripts from
+ * source).  The scripts run from the current directory, not from where
+ * they were saved from.  Bundles are in native byte order, so not
+ * portable between machines.
+ */
+RL_API bool rebSaveScriptBundle(const char * path, const char * const * files, size_t n);
+RL_API bool rebStartupWithScripts(const char * path);
+
+/*
+ * CHECKPOINTS
+ *
+ * Isolation between requests without a shutdown and startup.
+ * rebCheckpoint() records what each user word is set to, e.g. right after
+ * boot and preloading.  rebResetToCheckpoint() unsets every user word
+ * defined since, sets each one that isn't SAME? as recorded back to the
+ * very value it had (so `a: b: [1 2]` still share their block), and runs
+ * one RECYCLE, which sweeps up everything only reachable from what was
+ * thrown away.  Nothing is copied, so a reset costs a pass over the
+ * words, plus the RECYCLE.  It returns false if there is no checkpoint.
+ *
+ * Only which value each word holds is reset, not what's in the values:
+ * series changed in place (an APPEND to a preloaded block, or to one a
+ * preloaded function keeps) stay changed.  PROTECT what must not be, or
+ * make it again per request.  Changes made to LIB stay too, as do API
+ * handles that were never released, and what they keep alive; a request
+ * run inside a handle arena can't leave any.
+ */
+RL_API void rebCheckpoint(void);
+RL_API bool rebResetToCheckpoint(void);
+
+/*
+ * FAST EXIT
+ *
+ * What rebShutdown(clean) does: a clean shutdown tears the interpreter
+ * down, freeing every series, pool and table, so it could be started
+ * again (and leak checkers see nothing).  None of that commits data
+ * anywhere, so in release builds of the core an unclean shutdown does no
+ * work at all; debug builds still do a clean one, to check for leaks.
+ *
+ * rebShutdownFast() is for a process about to exit.  It flushes the C
+ * library's output buffers, where data written through stdio (by the
+ * core's console output, or by the embedder) may still be sitting, then
+ * does an unclean shutdown.  Writes to files and other ports are handed
+ * to the OS as they're made, so there's nothing more of theirs to flush.
+ * The heap isn't freed, and the GC doesn't run, so cleaners of HANDLE!s
+ * (e.g. the `drop` of a rebForeignHandle()) are never called.  The
+ * interpreter can't be used or started again afterwards.
+ */
+RL_API void rebShutdownFast(void);
+
+/*
+ * CONTINUATIONS
+ *
+ * Evaluation in slices, so one thread can take turns between scripts.
+ * rebOpenContinuation() takes a feed like rebValue()'s, but only loads it
+ * as code; rebResume() then runs it until `budget` evaluator ticks (see
+ * rebTick()) have gone by, and returns true once it's finished.  Cores
+ * built without the tick counter (release builds, where rebTick() is 0)
+ * count each top-level expression as one tick instead.
+ *
+ * The core's evaluator isn't stackless, so the slices are made between
+ * top-level expressions of the feed: a resume runs at least one, and runs
+ * each to completion, however many ticks it takes.  A script that does
+ * all its work in one expression (e.g. one long loop) gets no turns taken
+ * from it.  Failures propagate out of rebResume() as from rebValue(), and
+ * leave the continuation finished, but failed: resuming it again returns
+ * true without running anything, and it has no result.
+ *
+ * rebContinuationResult() gives the value of the last expression run,
+ * once finished (a handle like rebValue()'s), or NULL before then, if it
+ * was null, or if the continuation failed.  Continuations are tied to the interpreter they were
+ * opened in, and must be closed before it's shut down.
+ */
+typedef struct rebol_continuation REBCONT;
+
+RL_API REBCONT * rebOpenContinuation(const void * p, ...);
+RL_API bool rebResume(REBCONT * cont, uintptr_t budget);
+RL_API REBVAL * rebContinuationResult(REBCONT * cont);
+RL_API void rebCloseContinuation(REBCONT * cont);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  /* REBOL_SHIM_VALIST_H */
@@ -0,0 +1,40 @@
+//! Handle arenas: release every API handle made in a scope at once.
+//!
+//! While an `Arena` is alive, the handles the shim returns on this thread
+//! are recorded, and dropping the arena releases them with a single call.
+//! Arenas nest, so they must be dropped in the reverse order they were
+//! made (which scoping gives for free).
+
+use crate::*;
+use std::marker::PhantomData;
+
+pub struct Arena {
+    mark: size_t,
+    _thread_bound: PhantomData<*const ()>,
+}
+
+impl Arena {
+    pub fn open() -> Arena {
+        Arena {
+            mark: unsafe { rebOpenArena() },
+            _thread_bound: PhantomData,
+        }
+    }
+
+    /// Take `v` out of the arena, so it outlives it and must be released
+    /// some other way.
+    pub unsafe fn keep(&self, v: *mut Reb_Value) -> *mut Reb_Value {
+        rebUnarena(v)
+    }
+}
+
+impl Drop for Arena {
+    fn drop(&mut self) {
+        unsafe { rebCloseArena(self.mark) }
+    }
+}
+
+/// Release a batch of handles with one API entry.
+pub unsafe fn release_many(handles: &[*const Reb_Value]) {
+    rebReleaseMany(handles.as_ptr(), handles.len() as size_t)
+}
@@ -0,0 +1,199 @@
+//! A byte buffer in `rebMalloc()` memory.
+//!
+//! `Value::binary()` has to copy, because a `Vec<u8>` lives on the system
+//! heap.  A `RebBuffer` is filled the same way as a `Vec<u8>`, but its
+//! memory comes from `rebMalloc()`/`rebRealloc()`, so `into_binary()` can
+//! give it to the interpreter with `rebRepossess()` instead of copying.
+//! That memory is also counted by the GC when pacing collections, which
+//! system heap memory is not.
+//!
+//! Like any API memory, the buffer must not outlive the interpreter.
+
+use crate::*;
+use std::io;
+use std::ops::{Deref, DerefMut};
+use std::os::raw::c_void;
+use std::ptr;
+
+pub struct RebBuffer {
+    ptr: *mut u8,  // null until the first allocation
+    len: usize,
+    cap: usize,
+}
+
+impl RebBuffer {
+    #[inline]
+    pub fn new() -> RebBuffer {
+        RebBuffer { ptr: ptr::null_mut(), len: 0, cap: 0 }
+    }
+
+    /// Take ownership of `len` bytes from `rebMalloc()`, e.g. the result of
+    /// one of the API's `*Alloc` calls.
+    #[inline]
+    pub unsafe fn from_raw(ptr: *mut c_void, len: usize) -> RebBuffer {
+        RebBuffer { ptr: ptr as *mut u8, len, cap: len }
+    }
+
+    pub fn with_capacity(cap: usize) -> RebBuffer {
+        let mut buf = RebBuffer::new();
+        buf.reserve(cap);
+        buf
+    }
+
+    #[inline]
+    pub fn len(&self) -> usize {
+        self.len
+    }
+
+    #[inline]
+    pub fn is_empty(&self) -> bool {
+        self.len == 0
+    }
+
+    #[inline]
+    pub fn capacity(&self) -> usize {
+        self.cap
+    }
+
+    #[inline]
+    pub fn as_ptr(&self) -> *const u8 {
+        self.ptr
+    }
+
+    #[inline]
+    pub fn as_mut_ptr(&mut self) -> *mut u8 {
+        self.ptr
+    }
+
+    /// Make room for at least `additional` more bytes, growing geometrically.
+    pub fn reserve(&mut self, additional: usize) {
+        let needed = self.len.checked_add(additional).expect("capacity overflow");
+        if needed <= self.cap {
+            return;
+        }
+        let cap = std::cmp::max(needed, std::cmp::max(self.cap * 2, 64));
+        let ptr = unsafe {
+            if self.ptr.is_null() {
+                rebMalloc(cap as size_t)
+            } else {
+                rebRealloc(self.ptr as *mut c_void, cap as size_t)
+            }
+        };
+        // rebMalloc() fails with a Rebol error rather than giving null
+        self.ptr = ptr as *mut u8;
+        self.cap = cap;
+    }
+
+    /// See `Vec::set_len()`; bytes up to `len` must have been written.
+    #[inline]
+    pub unsafe fn set_len(&mut self, len: usize) {
+        debug_assert!(len <= self.cap);
+        self.len = len;
+    }
+
+    #[inline]
+    pub fn clear(&mut self) {
+        self.len = 0;
+    }
+
+    #[inline]
+    pub fn truncate(&mut self, len: usize) {
+        if len < self.len {
+            self.len = len;
+        }
+    }
+
+    #[inline]
+    pub fn push(&mut self, byte: u8) {
+        if self.len == self.cap {
+            self.reserve(1);
+        }
+        unsafe { *self.ptr.add(self.len) = byte };
+        self.len += 1;
+    }
+
+    pub fn extend_from_slice(&mut self, bytes: &[u8]) {
+        self.reserve(bytes.len());
+        unsafe {
+            ptr::copy_nonoverlapping(bytes.as_ptr(), self.ptr.add(self.len), bytes.len());
+        }
+        self.len += bytes.len();
+    }
+
+    /// Hand the memory to the interpreter as a BINARY! of `len()` bytes,
+    /// without copying.
+    pub fn into_binary(mut self) -> Value {
+        if self.ptr.is_null() {
+            self.reserve(1); // rebRepossess() needs an allocation
+        }
+        let ptr = std::mem::replace(&mut self.ptr, ptr::null_mut());
+        unsafe { Value::from_raw(rebRepossess(ptr as *mut c_void, self.len as size_t)).unwrap() }
+    }
+}
+
+impl Default for RebBuffer {
+    #[inline]
+    fn default() -> RebBuffer {
+        RebBuffer::new()
+    }
+}
+
+impl Drop for RebBuffer {
+    #[inline]
+    fn drop(&mut self) {
+        if !self.ptr.is_null() {
+            unsafe { rebFree(self.ptr as *mut c_void) }
+        }
+    }
+}
+
+impl Deref for RebBuffer {
+    type Target = [u8];
+
+    #[inline]
+    fn deref(&self) -> &[u8] {
+        if self.ptr.is_null() {
+            return &[];
+        }
+        unsafe { std::slice::from_raw_parts(self.ptr, self.len) }
+    }
+}
+
+impl DerefMut for RebBuffer {
+    #[inline]
+    fn deref_mut(&mut self) -> &mut [u8] {
+        if self.ptr.is_null() {
+            return &mut [];
+        }
+        unsafe { std::slice::from_raw_parts_mut(self.ptr, self.len) }
+    }
+}
+
+impl Extend<u8> for RebBuffer {
+    fn extend<I: IntoIterator<Item = u8>>(&mut self, iter: I) {
+        let iter = iter.into_iter();
+        self.reserve(iter.size_hint().0);
+        for byte in iter {
+            self.push(byte);
+        }
+    }
+}
+
+impl io::Write for RebBuffer {
+    #[inline]
+    fn write(&mut self, bytes: &[u8]) -> io::Result<usize> {
+        self.extend_from_slice(bytes);
+        Ok(bytes.len())
+    }
+
+    #[inline]
+    fn write_all(&mut self, bytes: &[u8]) -> io::Result<()> {
+        self.extend_from_slice(bytes);
+        Ok(())
+    }
+
+    #[inline]
+    fn flush(&mut self) -> io::Result<()> {
+        Ok(())
+    }
+}
@@ -0,0 +1,45 @@
+//! Script bundles: preloaded scripts gathered into one file for startup.
+//!
+//! The scripts still run on every startup; this only saves finding and
+//! reading them one by one.  See `rebStartupWithScripts()` in
+//! renc/shim/valist.h for why the booted state itself can't be saved.
+
+use crate::*;
+use std::ffi::CString;
+use std::io;
+use std::os::raw::c_char;
+use std::path::Path;
+
+fn c_path(path: &Path) -> io::Result<CString> {
+    let path = path.to_str().ok_or_else(|| {
+        io::Error::new(io::ErrorKind::InvalidInput, "path isn't UTF-8")
+    })?;
+    CString::new(path).map_err(|e| io::Error::new(io::ErrorKind::InvalidInput, e))
+}
+
+/// Write the scripts in `files` to a bundle at `path`, to be run in that
+/// order.  Doesn't need the interpreter.
+pub fn save<P: AsRef<Path>, F: AsRef<Path>>(path: P, files: &[F]) -> io::Result<()> {
+    let path = c_path(path.as_ref())?;
+    let files = files
+        .iter()
+        .map(|f| c_path(f.as_ref()))
+        .collect::<io::Result<Vec<_>>>()?;
+    let ptrs: Vec<*const c_char> = files.iter().map(|f| f.as_ptr()).collect();
+    if unsafe { rebSaveScriptBundle(path.as_ptr(), ptrs.as_ptr(), ptrs.len() as size_t) } {
+        Ok(())
+    } else {
+        Err(io::Error::new(io::ErrorKind::Other, "couldn't write script bundle"))
+    }
+}
+
+/// Boot the interpreter and run the bundle's scripts.  On an error the
+/// interpreter is booted all the same, without them.
+pub fn startup<P: AsRef<Path>>(path: P) -> io::Result<()> {
+    let path = c_path(path.as_ref())?;
+    if unsafe { rebStartupWithScripts(path.as_ptr()) } {
+        Ok(())
+    } else {
+        Err(io::Error::new(io::ErrorKind::InvalidData, "not a readable script bundle"))
+    }
+}
@@ -0,0 +1,20 @@
+//! Resetting the interpreter between requests, instead of restarting it.
+//!
+//! Call `checkpoint()` once the interpreter is set up, and `reset()`
+//! after each request.  See `rebCheckpoint()` in renc/shim/valist.h for
+//! what a reset does and doesn't undo.
+
+use crate::*;
+
+/// Record the user context as it is now, replacing any earlier record.
+#[inline]
+pub fn checkpoint() {
+    unsafe { rebCheckpoint() }
+}
+
+/// Put the user context back as recorded and collect the garbage; false
+/// if there's no checkpoint.
+#[inline]
+pub fn reset() -> bool {
+    unsafe { rebResetToCheckpoint() }
+}
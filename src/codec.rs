@@ -0,0 +1,544 @@
+//! Streaming compression, over the shim's codecs (see renc/shim/codec.h).
+//!
+//! `Encoder` compresses everything written to it into another `Write`, and
+//! `Decoder` decompresses what it reads from another `Read`, a buffer at a
+//! time, so neither the input nor the output has to be held in memory.
+//! Unlike the rest of the crate these don't need the interpreter, and can
+//! be used from any thread.
+
+use crate::*;
+use std::ffi::CStr;
+use std::io::{self, Read, Write};
+use std::os::raw::{c_int, c_void};
+use std::ptr::NonNull;
+use std::sync::Arc;
+
+const BUF_SIZE: usize = 64 * 1024;
+
+/// Framing of the compressed data.
+#[derive(Clone, Copy, Debug, PartialEq, Eq)]
+pub enum Format {
+    /// Raw DEFLATE, as `rebDeflateAlloc()`.
+    Deflate,
+    /// zlib envelope, as `rebZdeflateAlloc()`.
+    Zlib,
+    /// gzip envelope, as `rebGzipAlloc()`.
+    Gzip,
+}
+
+impl Format {
+    fn raw(self) -> c_int {
+        (match self {
+            Format::Deflate => REB_CODEC_DEFLATE,
+            Format::Zlib => REB_CODEC_ZLIB,
+            Format::Gzip => REB_CODEC_GZIP,
+        }) as c_int
+    }
+
+    fn from_raw(raw: c_int) -> Format {
+        match raw as u32 {
+            REB_CODEC_ZLIB => Format::Zlib,
+            REB_CODEC_GZIP => Format::Gzip,
+            _ => Format::Deflate,
+        }
+    }
+}
+
+/// How a compressor looks for matches (see zlib's `deflateInit2()`).
+#[derive(Clone, Copy, Debug, PartialEq, Eq)]
+pub enum Strategy {
+    Default,
+    Filtered,
+    HuffmanOnly,
+    Rle,
+    Fixed,
+}
+
+impl Strategy {
+    fn raw(self) -> c_int {
+        (match self {
+            Strategy::Default => REB_CODEC_DEFAULT_STRATEGY,
+            Strategy::Filtered => REB_CODEC_FILTERED,
+            Strategy::HuffmanOnly => REB_CODEC_HUFFMAN_ONLY,
+            Strategy::Rle => REB_CODEC_RLE,
+            Strategy::Fixed => REB_CODEC_FIXED,
+        }) as c_int
+    }
+}
+
+#[derive(Clone, Copy, Debug, PartialEq, Eq)]
+pub enum Flush {
+    None,
+    Sync,
+    Finish,
+}
+
+/// Outcome of one `Codec::step()`.
+#[derive(Clone, Copy, Debug)]
+pub struct Step {
+    pub consumed: usize,
+    pub produced: usize,
+    /// The end of the stream was produced (compressing) or read
+    /// (decompressing).
+    pub done: bool,
+}
+
+/// A compressor or decompressor context.
+pub struct Codec {
+    raw: NonNull<REBCDC>,
+    dict: Option<Arc<Dictionary>>,  // kept alive while in use
+}
+
+// A codec has no ties to the interpreter or to the thread that made it.
+unsafe impl Send for Codec {}
+
+impl Codec {
+    /// `level` is 0 (store) to 9 (smallest), or -1 for the default.
+    pub fn compressor(format: Format, level: i32) -> io::Result<Codec> {
+        let raw = unsafe { rebOpenCompressor(format.raw(), level as c_int) };
+        Codec::from_raw(raw, "bad compression level, or out of memory")
+    }
+
+    pub fn compressor_with(format: Format, level: i32, strategy: Strategy) -> io::Result<Codec> {
+        let mut codec = Codec::compressor(format, level)?;
+        codec.set_params(level, strategy)?;
+        Ok(codec)
+    }
+
+    pub fn decompressor(format: Format) -> io::Result<Codec> {
+        let raw = unsafe { rebOpenDecompressor(format.raw()) };
+        Codec::from_raw(raw, "out of memory")
+    }
+
+    fn from_raw(raw: *mut REBCDC, why: &str) -> io::Result<Codec> {
+        match NonNull::new(raw) {
+            Some(raw) => Ok(Codec { raw, dict: None }),
+            None => Err(io::Error::new(io::ErrorKind::Other, why)),
+        }
+    }
+
+    /// Move as much as will fit from `input` through to `output`.
+    pub fn step(&mut self, input: &[u8], output: &mut [u8], flush: Flush) -> io::Result<Step> {
+        let mut in_len = input.len() as size_t;
+        let mut out_len = output.len() as size_t;
+        let flush = match flush {
+            Flush::None => REB_CODEC_NO_FLUSH,
+            Flush::Sync => REB_CODEC_SYNC_FLUSH,
+            Flush::Finish => REB_CODEC_FINISH,
+        };
+        let status = unsafe {
+            rebCodecStep(
+                self.raw.as_ptr(),
+                input.as_ptr() as *const c_void,
+                &mut in_len,
+                output.as_mut_ptr() as *mut c_void,
+                &mut out_len,
+                flush as c_int,
+            )
+        };
+        self.check(status)?;
+        Ok(Step {
+            consumed: in_len as usize,
+            produced: out_len as usize,
+            done: status == REB_CODEC_DONE as c_int,
+        })
+    }
+
+    /// Start a new stream with the same settings, reusing the context.
+    #[inline]
+    pub fn reset(&mut self) {
+        unsafe { rebCodecReset(self.raw.as_ptr()) }
+    }
+
+    /// Reset a compressor, with a new level and strategy.
+    pub fn set_params(&mut self, level: i32, strategy: Strategy) -> io::Result<()> {
+        let status = unsafe { rebCodecParams(self.raw.as_ptr(), level as c_int, strategy.raw()) };
+        self.check(status).map(|_| ())
+    }
+
+    /// Reset the codec, and prime each stream from now on with `dict` (or
+    /// nothing).  Not possible with `Format::Gzip`.
+    pub fn set_dictionary(&mut self, dict: Option<Arc<Dictionary>>) -> io::Result<()> {
+        let raw = dict.as_ref().map_or(std::ptr::null(), |d| d.raw.as_ptr() as *const REBCDD);
+        let status = unsafe { rebCodecDictionary(self.raw.as_ptr(), raw) };
+        self.check(status)?;
+        self.dict = dict;
+        Ok(())
+    }
+
+    /// Most a compressor can produce from `len` bytes with its settings.
+    #[inline]
+    pub fn compress_bound(&self, len: usize) -> usize {
+        unsafe { rebCompressBound(self.raw.as_ptr(), len as size_t) as usize }
+    }
+
+    /// Compress all of `input` as a stream of its own into `output`, giving
+    /// the compressed size.  Nothing is allocated; an `output` of
+    /// `compress_bound(input.len())` always fits.
+    pub fn compress_into(&mut self, input: &[u8], output: &mut [u8]) -> io::Result<usize> {
+        let mut out_len = output.len() as size_t;
+        let status = unsafe {
+            rebCompressInto(
+                self.raw.as_ptr(),
+                output.as_mut_ptr() as *mut c_void,
+                &mut out_len,
+                input.as_ptr() as *const c_void,
+                input.len() as size_t,
+            )
+        };
+        self.check(status)?;
+        Ok(out_len as usize)
+    }
+
+    /// Decompress a whole stream into `output`, giving the size.
+    pub fn decompress_into(&mut self, input: &[u8], output: &mut [u8]) -> io::Result<usize> {
+        let mut out_len = output.len() as size_t;
+        let status = unsafe {
+            rebDecompressInto(
+                self.raw.as_ptr(),
+                output.as_mut_ptr() as *mut c_void,
+                &mut out_len,
+                input.as_ptr() as *const c_void,
+                input.len() as size_t,
+            )
+        };
+        self.check(status)?;
+        Ok(out_len as usize)
+    }
+
+    fn check(&self, status: c_int) -> io::Result<c_int> {
+        if status == REB_CODEC_ERROR as c_int {
+            let msg = unsafe { CStr::from_ptr(rebCodecError(self.raw.as_ptr())) };
+            return Err(io::Error::new(io::ErrorKind::InvalidData, msg.to_string_lossy()));
+        }
+        Ok(status)
+    }
+}
+
+impl Drop for Codec {
+    #[inline]
+    fn drop(&mut self) {
+        unsafe { rebCloseCodec(self.raw.as_ptr()) }
+    }
+}
+
+/// A preset dictionary: typical content to prime each stream with, for
+/// much better compression of small messages.  The other end has to use
+/// the same one.  Only its last 32K is kept.
+pub struct Dictionary {
+    raw: NonNull<REBCDD>,
+}
+
+// Immutable once made.
+unsafe impl Send for Dictionary {}
+unsafe impl Sync for Dictionary {}
+
+impl Dictionary {
+    pub fn new(data: &[u8]) -> io::Result<Arc<Dictionary>> {
+        let raw = unsafe { rebOpenDictionary(data.as_ptr() as *const c_void, data.len() as size_t) };
+        match NonNull::new(raw) {
+            Some(raw) => Ok(Arc::new(Dictionary { raw })),
+            None => Err(io::Error::new(io::ErrorKind::Other, "out of memory")),
+        }
+    }
+}
+
+impl Drop for Dictionary {
+    #[inline]
+    fn drop(&mut self) {
+        unsafe { rebCloseDictionary(self.raw.as_ptr()) }
+    }
+}
+
+/// CRC-32 of `data`, continuing from `crc` (0 to start).
+#[inline]
+pub fn crc32(crc: u32, data: &[u8]) -> u32 {
+    unsafe { rebCrc32(crc as _, data.as_ptr() as *const c_void, data.len() as size_t) as u32 }
+}
+
+/// CRC-32 of two pieces end to end, from their CRCs and the second's size.
+#[inline]
+pub fn crc32_combine(crc1: u32, crc2: u32, size2: usize) -> u32 {
+    unsafe { rebCrc32Combine(crc1 as _, crc2 as _, size2 as size_t) as u32 }
+}
+
+/// Decompress all of `input` into `rebMalloc()` memory with
+/// `rebDecompressAlloc()`, giving the data and its format.  With `format`
+/// of `None` the format is detected; pass the one that comes back for
+/// more data from the same source to skip that.  `size_hint` is the
+/// expected size, if known (0 if not), so the output can be allocated
+/// once.  Unlike the rest of this module, this needs the interpreter, and
+/// bad data is a Rebol failure.
+pub fn decompress(input: &[u8], format: Option<Format>, size_hint: usize) -> (RebBuffer, Format) {
+    let mut raw = format.map_or(-1, Format::raw);
+    let mut len: size_t = 0;
+    unsafe {
+        let ptr = rebDecompressAlloc(
+            &mut len,
+            &mut raw,
+            input.as_ptr() as *const c_void,
+            input.len() as size_t,
+            -1,
+            size_hint as size_t,
+        );
+        (RebBuffer::from_raw(ptr, len as usize), Format::from_raw(raw))
+    }
+}
+
+/// Compresses what is written to it into `W`.
+///
+/// Call `finish()` to write the end of the stream and get `W` back.  If
+/// it is just dropped, the stream is finished then, ignoring errors.
+pub struct Encoder<W: Write> {
+    codec: Codec,
+    inner: Option<W>,
+    buf: Box<[u8]>,
+}
+
+impl<W: Write> Encoder<W> {
+    pub fn new(inner: W, format: Format, level: i32) -> io::Result<Encoder<W>> {
+        Ok(Encoder {
+            codec: Codec::compressor(format, level)?,
+            inner: Some(inner),
+            buf: vec![0; BUF_SIZE].into_boxed_slice(),
+        })
+    }
+
+    #[inline]
+    pub fn get_ref(&self) -> &W {
+        self.inner.as_ref().unwrap()
+    }
+
+    /// Run the codec over `input` until it has all been taken and (unless
+    /// `Flush::None`) everything due has been written out.
+    fn pump(&mut self, mut input: &[u8], flush: Flush) -> io::Result<bool> {
+        let inner = self.inner.as_mut().unwrap();
+        loop {
+            let step = self.codec.step(input, &mut self.buf, flush)?;
+            input = &input[step.consumed..];
+            inner.write_all(&self.buf[..step.produced])?;
+            if step.done {
+                return Ok(true);
+            }
+            // A step that doesn't fill the buffer had nothing more to give.
+            if input.is_empty() && step.produced < self.buf.len() {
+                return Ok(false);
+            }
+        }
+    }
+
+    pub fn finish(mut self) -> io::Result<W> {
+        while !self.pump(&[], Flush::Finish)? {}
+        Ok(self.inner.take().unwrap())
+    }
+}
+
+impl<W: Write> Write for Encoder<W> {
+    fn write(&mut self, input: &[u8]) -> io::Result<usize> {
+        self.pump(input, Flush::None)?;
+        Ok(input.len())
+    }
+
+    /// Writes out everything written so far (as a sync flush, so the
+    /// stream can be decoded up to here), and flushes `W`.
+    fn flush(&mut self) -> io::Result<()> {
+        self.pump(&[], Flush::Sync)?;
+        self.inner.as_mut().unwrap().flush()
+    }
+}
+
+impl<W: Write> Drop for Encoder<W> {
+    fn drop(&mut self) {
+        if self.inner.is_some() {
+            let _ = self.pump(&[], Flush::Finish);
+        }
+    }
+}
+
+/// Decompresses what it reads from `R`.
+pub struct Decoder<R: Read> {
+    codec: Codec,
+    inner: R,
+    buf: Box<[u8]>,
+    pos: usize,
+    len: usize,
+    done: bool,
+}
+
+impl<R: Read> Decoder<R> {
+    pub fn new(inner: R, format: Format) -> io::Result<Decoder<R>> {
+        Ok(Decoder {
+            codec: Codec::decompressor(format)?,
+            inner,
+            buf: vec![0; BUF_SIZE].into_boxed_slice(),
+            pos: 0,
+            len: 0,
+            done: false,
+        })
+    }
+
+    #[inline]
+    pub fn get_ref(&self) -> &R {
+        &self.inner
+    }
+
+    /// `R`, positioned at the end of what has been read so far; any of it
+    /// past the end of the compressed stream is lost.
+    #[inline]
+    pub fn into_inner(self) -> R {
+        self.inner
+    }
+}
+
+impl<R: Read> Read for Decoder<R> {
+    fn read(&mut self, out: &mut [u8]) -> io::Result<usize> {
+        if self.done || out.is_empty() {
+            return Ok(0);
+        }
+        loop {
+            if self.pos == self.len {
+                // The codec may be holding output back from input it has
+                // already taken (e.g. the rest of a match that didn't fit
+                // in the last `out`), which has to come out first.
+                let step = self.codec.step(&[], out, Flush::None)?;
+                self.done = step.done;
+                if step.produced != 0 || step.done {
+                    return Ok(step.produced);
+                }
+
+                self.pos = 0;
+                self.len = self.inner.read(&mut self.buf)?;
+                if self.len == 0 {
+                    return Err(io::Error::new(
+                        io::ErrorKind::UnexpectedEof,
+                        "compressed stream ended early",
+                    ));
+                }
+            }
+            let step = self.codec.step(&self.buf[self.pos..self.len], out, Flush::None)?;
+            self.pos += step.consumed;
+            self.done = step.done;
+            if step.produced != 0 || step.done {
+                return Ok(step.produced);
+            }
+        }
+    }
+}
+
+/// gzip compression of a whole buffer on several threads, pigz-style.
+///
+/// The input is cut into blocks which are DEFLATEd independently, each
+/// ending on a byte boundary (with a sync flush) except the last, so they
+/// concatenate into one DEFLATE stream.  Their CRCs are combined for the
+/// trailer.  The result is a single-member gzip any gunzip can read.
+/// Blocks don't share history, so for small blocks the output is a little
+/// bigger than single-threaded compression gives.
+#[derive(Clone, Debug)]
+pub struct ParallelGzip {
+    threads: usize,
+    block_size: usize,
+    level: i32,
+}
+
+impl Default for ParallelGzip {
+    fn default() -> ParallelGzip {
+        ParallelGzip {
+            threads: std::thread::available_parallelism().map(|n| n.get()).unwrap_or(1),
+            block_size: 128 * 1024,
+            level: -1,
+        }
+    }
+}
+
+impl ParallelGzip {
+    #[inline]
+    pub fn new() -> ParallelGzip {
+        ParallelGzip::default()
+    }
+
+    /// Number of compressing threads (at least 1).
+    pub fn threads(mut self, threads: usize) -> ParallelGzip {
+        self.threads = std::cmp::max(threads, 1);
+        self
+    }
+
+    /// Bytes of input per block (at least 1K).
+    pub fn block_size(mut self, block_size: usize) -> ParallelGzip {
+        self.block_size = std::cmp::max(block_size, 1024);
+        self
+    }
+
+    /// 0 (store) to 9 (smallest), or -1 for the default.
+    pub fn level(mut self, level: i32) -> ParallelGzip {
+        self.level = level;
+        self
+    }
+
+    pub fn compress(&self, input: &[u8]) -> io::Result<Vec<u8>> {
+        use std::sync::atomic::{AtomicUsize, Ordering};
+        use std::sync::Mutex;
+
+        let num_blocks = std::cmp::max((input.len() + self.block_size - 1) / self.block_size, 1);
+        let blocks: Vec<Mutex<Option<(Vec<u8>, u32)>>> =
+            (0..num_blocks).map(|_| Mutex::new(None)).collect();
+        let next = AtomicUsize::new(0);
+
+        let work = || -> io::Result<()> {
+            let mut codec = Codec::compressor(Format::Deflate, self.level)?;
+            let mut buf = vec![0; BUF_SIZE];
+            loop {
+                let i = next.fetch_add(1, Ordering::Relaxed);
+                if i >= num_blocks {
+                    return Ok(());
+                }
+                let start = i * self.block_size;
+                let end = std::cmp::min(start + self.block_size, input.len());
+                let block = &input[start..end];
+                let last = i == num_blocks - 1;
+
+                codec.reset();
+                let deflated = deflate_block(&mut codec, &mut buf, block, last)?;
+                *blocks[i].lock().unwrap() = Some((deflated, crc32(0, block)));
+            }
+        };
+
+        let threads = std::cmp::min(self.threads, num_blocks);
+        std::thread::scope(|scope| {
+            let helpers: Vec<_> = (1..threads).map(|_| scope.spawn(&work)).collect();
+            let mut result = work();
+            for helper in helpers {
+                let joined = helper.join().unwrap();
+                result = result.and(joined);
+            }
+            result
+        })?;
+
+        // gzip header: no name or mtime, unknown OS
+        let mut out = vec![0x1f, 0x8b, 8, 0, 0, 0, 0, 0, 0, 255];
+        let mut crc = 0;
+        for (i, block) in blocks.into_iter().enumerate() {
+            let (deflated, block_crc) = block.into_inner().unwrap().unwrap();
+            let size = std::cmp::min(self.block_size, input.len() - i * self.block_size);
+            crc = crc32_combine(crc, block_crc, size);
+            out.extend_from_slice(&deflated);
+        }
+        out.extend_from_slice(&crc.to_le_bytes());
+        out.extend_from_slice(&(input.len() as u32).to_le_bytes());
+        Ok(out)
+    }
+}
+
+/// Raw DEFLATE of one block: byte-aligned and unterminated with a sync
+/// flush, unless it is the last one.
+fn deflate_block(codec: &mut Codec, buf: &mut [u8], mut block: &[u8], last: bool) -> io::Result<Vec<u8>> {
+    let flush = if last { Flush::Finish } else { Flush::Sync };
+    let mut out = Vec::with_capacity(block.len() / 2 + 64);
+    loop {
+        let step = codec.step(block, buf, flush)?;
+        block = &block[step.consumed..];
+        out.extend_from_slice(&buf[..step.produced]);
+        if step.done || (!last && block.is_empty() && step.produced < buf.len()) {
+            return Ok(out);
+        }
+    }
+}
@@ -0,0 +1,57 @@
+//! Evaluation in slices, for taking turns between scripts on one thread.
+//!
+//! `resume()` runs a `Continuation`'s code for about `budget` evaluator
+//! ticks, then hands control back; a host can go round its scripts
+//! resuming each in turn, so a long one doesn't hold up the rest.  Slices
+//! end between top-level expressions of the code, and cores without the
+//! tick counter count an expression as a tick.  See
+//! `rebOpenContinuation()` in renc/shim/valist.h.
+
+use crate::feed::{self, FeedItem, Fragment};
+use crate::*;
+use std::marker::PhantomData;
+use std::ptr::NonNull;
+
+pub struct Continuation {
+    raw: NonNull<REBCONT>,
+    _thread_bound: PhantomData<*const ()>,
+}
+
+impl Continuation {
+    /// Load `code` (bound as `reb!()` would bind it), without running any.
+    pub fn new(code: &str) -> Continuation {
+        let frag = Fragment::new(code);
+        let raw = unsafe {
+            rebOpenContinuation(frag.feed_ptr(), feed::END)
+        };
+        Continuation {
+            raw: NonNull::new(raw).expect("rebOpenContinuation() gave NULL"),
+            _thread_bound: PhantomData,
+        }
+    }
+
+    /// Run at least one more expression, and on until `budget` ticks have
+    /// gone by; true once all the code has run.
+    #[inline]
+    pub fn resume(&mut self, budget: usize) -> bool {
+        unsafe { rebResume(self.raw.as_ptr(), budget as uintptr_t) }
+    }
+
+    /// Run to the end.
+    pub fn finish(&mut self) -> Option<Value> {
+        while !self.resume(usize::max_value()) {}
+        self.result()
+    }
+
+    /// The last expression's value, once finished (`None` before then, if
+    /// it was null, or if the code failed).
+    pub fn result(&self) -> Option<Value> {
+        unsafe { Value::from_raw(rebContinuationResult(self.raw.as_ptr())) }
+    }
+}
+
+impl Drop for Continuation {
+    fn drop(&mut self) {
+        unsafe { rebCloseContinuation(self.raw.as_ptr()) }
+    }
+}
@@ -0,0 +1,224 @@
+//! Evaluation as `Future`s, for async code.
+//!
+//! The interpreter blocks whoever calls into it until it's done, which
+//! would stall an async executor's thread.  An `Evaluator` gives the
+//! interpreter a thread of its own, and `eval()` sends it a script,
+//! giving back an `Evaluation` that completes with the result.  The thread
+//! runs every pending script as a `Continuation`, a slice of `slice` ticks
+//! at a time in turn, so a long script doesn't hold up short ones sent
+//! after it.  But slices only end between a script's top-level
+//! expressions (see `continuation`), so one long expression, such as a
+//! LOOP, runs to its end in one go and holds up everything meanwhile.
+//! Loading a script, which scans all of it, is done in one go too.
+//!
+//! Only `std` is used: an `Evaluation` wakes its task through the `Waker`
+//! it was last polled with, so it works under any executor.  `block_on()`
+//! is there for callers that aren't in async code.
+//!
+//! The evaluator owns the interpreter: it starts it, and shuts it down
+//! once dropped, after finishing what's still being waited on.  Nothing
+//! else in the process may use the interpreter meanwhile.
+
+use crate::continuation::Continuation;
+use crate::*;
+use std::collections::VecDeque;
+use std::future::Future;
+use std::io;
+use std::os::raw::c_void;
+use std::pin::Pin;
+use std::ptr;
+use std::sync::mpsc::{self, Receiver, Sender, TryRecvError};
+use std::sync::{Arc, Mutex};
+use std::task::{Context, Poll, Wake, Waker};
+use std::thread::{self, JoinHandle, Thread};
+
+pub struct Evaluator {
+    jobs: Option<Mutex<Sender<Job>>>,
+    thread: Option<JoinHandle<()>>,
+}
+
+/// Completes with the MOLD of the script's result (empty if it was null),
+/// or an `Other` error with the text of a Rebol error.  Dropping it before
+/// then cancels the script at the end of its current slice, which is no
+/// sooner than the end of the top-level expression being run: one that
+/// has started can't be cancelled, and runs to completion.
+pub struct Evaluation {
+    shared: Arc<Shared>,
+}
+
+struct Job {
+    script: String,
+    shared: Arc<Shared>,
+}
+
+#[derive(Default)]
+struct Shared {
+    state: Mutex<State>,
+}
+
+#[derive(Default)]
+struct State {
+    outcome: Option<io::Result<String>>,
+    waker: Option<Waker>,
+}
+
+impl Evaluator {
+    /// Start the interpreter on a new thread, to run scripts `slice` ticks
+    /// at a time.
+    pub fn start(slice: usize) -> Evaluator {
+        let (jobs, received) = mpsc::channel();
+        let thread = thread::Builder::new()
+            .name("renc-evaluator".into())
+            .spawn(move || serve(received, slice))
+            .expect("can't spawn the evaluator thread");
+        Evaluator { jobs: Some(Mutex::new(jobs)), thread: Some(thread) }
+    }
+
+    pub fn eval(&self, script: &str) -> Evaluation {
+        let shared = Arc::new(Shared::default());
+        let job = Job { script: script.to_owned(), shared: shared.clone() };
+        let jobs = self.jobs.as_ref().unwrap().lock().unwrap();
+        if jobs.send(job).is_err() {
+            shared.finish(Err(io::Error::new(io::ErrorKind::BrokenPipe, "evaluator thread is gone")));
+        }
+        Evaluation { shared }
+    }
+}
+
+impl Drop for Evaluator {
+    fn drop(&mut self) {
+        self.jobs = None; // so the thread sees the end of the jobs
+        if let Some(thread) = self.thread.take() {
+            let _ = thread.join();
+        }
+    }
+}
+
+impl Future for Evaluation {
+    type Output = io::Result<String>;
+
+    fn poll(self: Pin<&mut Self>, cx: &mut Context<'_>) -> Poll<io::Result<String>> {
+        let mut state = self.shared.state.lock().unwrap();
+        match state.outcome.take() {
+            Some(outcome) => Poll::Ready(outcome),
+            None => {
+                match state.waker {
+                    Some(ref waker) if waker.will_wake(cx.waker()) => {}
+                    _ => state.waker = Some(cx.waker().clone()),
+                }
+                Poll::Pending
+            }
+        }
+    }
+}
+
+impl Shared {
+    fn finish(&self, outcome: io::Result<String>) {
+        let waker = {
+            let mut state = self.state.lock().unwrap();
+            state.outcome = Some(outcome);
+            state.waker.take()
+        };
+        if let Some(waker) = waker {
+            waker.wake();
+        }
+    }
+}
+
+/// The evaluator thread: take turns between the scripts sent to it, and
+/// wait for more when there are none.
+fn serve(jobs: Receiver<Job>, slice: usize) {
+    unsafe { rebStartup() };
+
+    let mut running: VecDeque<(Continuation, Arc<Shared>)> = VecDeque::new();
+    let mut open = true;
+    loop {
+        if running.is_empty() {
+            match jobs.recv() {
+                Ok(job) => load(job, &mut running),
+                Err(_) => break,
+            }
+        }
+        while open {
+            match jobs.try_recv() {
+                Ok(job) => load(job, &mut running),
+                Err(TryRecvError::Empty) => break,
+                Err(TryRecvError::Disconnected) => open = false,
+            }
+        }
+
+        let (mut cont, shared) = match running.pop_front() {
+            Some(next) => next,
+            None => continue,
+        };
+        if Arc::strong_count(&shared) == 1 {
+            continue; // its Evaluation was dropped
+        }
+        let mut done = false;
+        match rescue(|| done = cont.resume(slice)) {
+            Ok(()) if !done => running.push_back((cont, shared)),
+            Ok(()) => shared.finish(Ok(cont.result().map_or_else(String::new, |v| mold(&v)))),
+            Err(error) => shared.finish(Err(rebol_error(&error))),
+        }
+    }
+
+    unsafe { rebShutdown(true) };
+}
+
+fn load(job: Job, running: &mut VecDeque<(Continuation, Arc<Shared>)>) {
+    let mut cont = None;
+    match rescue(|| cont = Some(Continuation::new(&job.script))) {
+        Ok(()) => running.push_back((cont.unwrap(), job.shared)),
+        Err(error) => job.shared.finish(Err(rebol_error(&error))),
+    }
+}
+
+/// Run `f`, giving the ERROR! if a Rebol failure unwinds out of it.  `f`
+/// must not own anything that needs dropping when that happens.
+fn rescue<F: FnMut()>(mut f: F) -> Result<(), Value> {
+    unsafe extern "C" fn call(opaque: *mut c_void) -> *mut Reb_Value {
+        let f = &mut *(opaque as *mut &mut dyn FnMut());
+        f();
+        ptr::null_mut()
+    }
+    let mut f: &mut dyn FnMut() = &mut f;
+    let error = unsafe { rebRescue(Some(call), &mut f as *mut &mut dyn FnMut() as *mut c_void) };
+    match unsafe { Value::from_raw(error) } {
+        None => Ok(()),
+        Some(error) => Err(error),
+    }
+}
+
+fn mold(value: &Value) -> String {
+    unsafe {
+        let quoted = rebQUOTING(value.as_ptr() as *const c_void, feed::END);
+        let text = feed::value(&[b"mold\0".as_ptr() as *const c_void, quoted]);
+        Value::from_raw(text).unwrap().to_string()
+    }
+}
+
+fn rebol_error(error: &Value) -> io::Error {
+    io::Error::new(io::ErrorKind::Other, reb!("form", error).unwrap().to_string())
+}
+
+/// Run a future to completion on the calling thread, parking it while the
+/// future is pending.
+pub fn block_on<F: Future>(future: F) -> F::Output {
+    struct Unpark(Thread);
+
+    impl Wake for Unpark {
+        fn wake(self: Arc<Self>) {
+            self.0.unpark();
+        }
+    }
+
+    let waker = Waker::from(Arc::new(Unpark(thread::current())));
+    let mut cx = Context::from_waker(&waker);
+    let mut future = Box::pin(future);
+    loop {
+        if let Poll::Ready(output) = future.as_mut().poll(&mut cx) {
+            return output;
+        }
+        thread::park();
+    }
+}
@@ -0,0 +1,246 @@
+//! Array feeds: the `rebXXXArray()` entry points of the shim.
+//!
+//! The variadic API (`rebValue(p, ...)`) has to be called with an arity
+//! fixed at compile time, with `END` on the tail.  These take the feed as
+//! a slice instead, so it can be assembled at runtime.  Items are whatever
+//! would have been passed variadically: NUL-terminated UTF-8 fragments,
+//! sized `Fragment`s, `REBVAL` pointers, `rebQ()`/`rebR()` instructions.
+//!
+//! All of these are `unsafe` for the same reason the variadic calls are:
+//! nothing checks that the items point at what the evaluator expects.
+
+use crate::*;
+use std::marker::PhantomData;
+use std::os::raw::{c_char, c_void};
+
+/// Terminates a variadic feed; the same bytes as `rebEND` in rebol.h.
+///
+/// Not needed by the array entry points, where the slice length is the
+/// terminator.
+pub const END: *const c_void = b"\x80\0" as *const [u8; 2] as *const c_void;
+
+pub unsafe fn value(items: &[*const c_void]) -> *mut Reb_Value {
+    rebValueArray(items.as_ptr(), items.len() as size_t)
+}
+
+pub unsafe fn value_q(items: &[*const c_void]) -> *mut Reb_Value {
+    rebValueArrayQ(items.as_ptr(), items.len() as size_t)
+}
+
+pub unsafe fn elide(items: &[*const c_void]) {
+    rebElideArray(items.as_ptr(), items.len() as size_t)
+}
+
+pub unsafe fn did(items: &[*const c_void]) -> bool {
+    rebDidArray(items.as_ptr(), items.len() as size_t)
+}
+
+pub unsafe fn not(items: &[*const c_void]) -> bool {
+    rebNotArray(items.as_ptr(), items.len() as size_t)
+}
+
+pub unsafe fn unbox_integer(items: &[*const c_void]) -> i64 {
+    rebUnboxIntegerArray(items.as_ptr(), items.len() as size_t) as i64
+}
+
+pub unsafe fn unbox_decimal(items: &[*const c_void]) -> f64 {
+    rebUnboxDecimalArray(items.as_ptr(), items.len() as size_t)
+}
+
+/// Result must be released with `rebFree()`.
+pub unsafe fn spell(items: &[*const c_void]) -> *mut c_char {
+    rebSpellArray(items.as_ptr(), items.len() as size_t)
+}
+
+/// Evaluate once and spell the result into `out`, reusing its capacity.
+///
+/// Rebol text is always valid UTF-8, which is what makes filling the
+/// `String`'s bytes directly sound.
+pub unsafe fn spell_into(out: &mut String, items: &[*const c_void]) {
+    let vec = out.as_mut_vec();
+    let size = rebSpellIntoGrowArray(
+        Some(grow_vec),
+        vec as *mut Vec<u8> as *mut c_void,
+        items.as_ptr(),
+        items.len() as size_t,
+    );
+    vec.set_len(size as usize);
+}
+
+/// Evaluate once and put the resulting BINARY!'s bytes in `out`, reusing
+/// its capacity.
+pub unsafe fn bytes_into(out: &mut Vec<u8>, items: &[*const c_void]) {
+    let size = rebBytesIntoGrowArray(
+        Some(grow_vec),
+        out as *mut Vec<u8> as *mut c_void,
+        items.as_ptr(),
+        items.len() as size_t,
+    );
+    out.set_len(size as usize);
+}
+
+unsafe extern "C" fn grow_vec(opaque: *mut c_void, size: size_t) -> *mut c_void {
+    let vec = &mut *(opaque as *mut Vec<u8>);
+    vec.clear();
+    vec.reserve(size as usize);
+    vec.as_mut_ptr() as *mut c_void
+}
+
+/// A UTF-8 fragment given by pointer and size, so a `&str` (or a slice of
+/// a larger buffer, like an mmap'd script) can go in a feed in place of a
+/// NUL-terminated fragment without being copied into a `CString`.
+///
+/// The shim still stages a terminated copy before the core scans it (into
+/// a stack buffer, for fragments that fit), since the core has no entry
+/// point that scans sized text.
+#[repr(transparent)]
+pub struct Fragment<'a> {
+    frag: REBFRG,
+    _text: PhantomData<&'a str>,
+}
+
+impl<'a> Fragment<'a> {
+    #[inline]
+    pub fn new(utf8: &'a str) -> Fragment<'a> {
+        let mut header = [0; 8];
+        header[0] = REBOL_SIZED_FRAGMENT_BYTE as u8;
+        Fragment {
+            frag: REBFRG {
+                header,
+                utf8: utf8.as_ptr() as *const c_char,
+                size: utf8.len() as size_t,
+            },
+            _text: PhantomData,
+        }
+    }
+}
+
+/// Something that can be spliced into a feed by the `reb!` macros.
+///
+/// # Safety
+///
+/// The macros hand `feed_ptr()` to the core from safe code, so it must be
+/// something a feed can hold, alive for as long as `self` is: an API
+/// value, a NUL-terminated UTF-8 fragment, or an instruction such as
+/// `rebQUOTING()` gives.  `is_sized()` must be true exactly when it's a
+/// sized fragment (REBFRG), which the variadic entry points don't take.
+pub unsafe trait FeedItem {
+    fn feed_ptr(&self) -> *const c_void;
+
+    /// Whether this is a sized `Fragment`, which only the array entry
+    /// points take.
+    #[inline]
+    fn is_sized(&self) -> bool {
+        false
+    }
+}
+
+unsafe impl FeedItem for Value {
+    #[inline]
+    fn feed_ptr(&self) -> *const c_void {
+        self.as_ptr() as *const c_void
+    }
+}
+
+unsafe impl<'a> FeedItem for ValueRef<'a> {
+    #[inline]
+    fn feed_ptr(&self) -> *const c_void {
+        self.as_ptr() as *const c_void
+    }
+}
+
+unsafe impl<'a> FeedItem for Fragment<'a> {
+    #[inline]
+    fn feed_ptr(&self) -> *const c_void {
+        &self.frag as *const REBFRG as *const c_void
+    }
+
+    #[inline]
+    fn is_sized(&self) -> bool {
+        true
+    }
+}
+
+unsafe impl<'a, T: FeedItem + ?Sized> FeedItem for &'a T {
+    #[inline]
+    fn feed_ptr(&self) -> *const c_void {
+        (**self).feed_ptr()
+    }
+
+    #[inline]
+    fn is_sized(&self) -> bool {
+        (**self).is_sized()
+    }
+}
+
+/// Evaluate a feed, as `rebValue()`: `reb!("1 +", one)`.
+///
+/// Literals become static NUL-terminated UTF-8 fragments at compile time,
+/// other items are spliced through `FeedItem`, and `END` is appended, so
+/// the call is a single variadic `rebValue()` with nothing allocated.  A
+/// feed with a sized `Fragment` in it goes to `rebValueArray()` instead,
+/// as the variadic entry points don't take them.  Gives `None` if the
+/// result is Rebol's null.
+#[macro_export]
+macro_rules! reb {
+    ($($items:tt)*) => {{
+        let p = $crate::__reb_feed!($crate::rebValue, $crate::rebValueArray; [] [] $($items)*);
+        unsafe { $crate::Value::from_raw(p) }
+    }};
+}
+
+/// Evaluate a feed for its side effects, as `rebElide()`.
+#[macro_export]
+macro_rules! reb_elide {
+    ($($items:tt)*) => {
+        $crate::__reb_feed!($crate::rebElide, $crate::rebElideArray; [] [] $($items)*)
+    };
+}
+
+/// Evaluate a feed for its truthiness, as `rebDid()`.
+#[macro_export]
+macro_rules! reb_did {
+    ($($items:tt)*) => {
+        $crate::__reb_feed!($crate::rebDid, $crate::rebDidArray; [] [] $($items)*)
+    };
+}
+
+/// Munches the items of the `reb!` macros into a variadic call (or an
+/// array one, if any item is sized).
+///
+/// Each spliced item is bound by reference in its own (hygienic) `let`,
+/// so temporaries live through the call and user expressions are not
+/// evaluated inside the `unsafe` block.  Whether an item is sized is known
+/// from its type, so only one of the two calls survives optimization.
+#[doc(hidden)]
+#[macro_export]
+macro_rules! __reb_feed {
+    ($f:path, $array:path; [$($done:expr),*] [$($sized:expr),*]) => {
+        if false $(|| $sized)* {
+            let items: &[*const ::std::os::raw::c_void] = &[$($done),*];
+            unsafe { $array(items.as_ptr(), items.len() as $crate::size_t) }
+        } else {
+            unsafe { $f($($done,)* $crate::feed::END) }
+        }
+    };
+    ($f:path, $array:path; [$($done:expr),*] [$($sized:expr),*] $lit:literal $(, $($rest:tt)*)?) => {
+        $crate::__reb_feed!(
+            $f, $array; [
+                $($done,)*
+                concat!($lit, "\0").as_ptr() as *const ::std::os::raw::c_void
+            ] [$($sized),*] $($($rest)*)?
+        )
+    };
+    ($f:path, $array:path; [$($done:expr),*] [$($sized:expr),*] $item:expr $(, $($rest:tt)*)?) => {{
+        let item = &$item;
+        $crate::__reb_feed!(
+            $f, $array; [
+                $($done,)*
+                $crate::feed::FeedItem::feed_ptr(item)
+            ] [
+                $($sized,)*
+                $crate::feed::FeedItem::is_sized(item)
+            ] $($($rest)*)?
+        )
+    }};
+}
@@ -0,0 +1,104 @@
+//! Independent interpreters, e.g. one per worker thread.
+//!
+//! The core keeps its state in globals, so `rebStartup()` gives one
+//! interpreter per process.  An `Instance` is another whole copy of libr3
+//! (see `rebCreateInstance()` in renc/shim/valist.h), with its own heap,
+//! GC and contexts, so threads that each own one can run scripts at the
+//! same time.  Needs the `instances` feature; without it `Instance::new()`
+//! gives an error.
+//!
+//! While an instance is entered, every API call on the thread goes to it.
+//! Values and `RebBuffer`s must not be carried from one instance to
+//! another, or outlive theirs.  `run()` sees to that: what goes in and out
+//! of it must be `Send`, which nothing holding interpreter memory is
+//! (`Value`, `RebBuffer`, `Continuation`, `Prepared`...), so all of those
+//! are dropped before it returns, and so before the instance can be.
+//! Except through a thread-local: see `run()`'s docs for that hole.
+//! An instance is tied to the thread that made it (the type is neither
+//! `Send` nor `Sync`).
+
+use crate::*;
+use std::ffi::{CStr, CString};
+use std::io;
+use std::marker::PhantomData;
+use std::ptr::{self, NonNull};
+
+pub struct Instance {
+    raw: NonNull<REBINST>,
+    _thread_bound: PhantomData<*const ()>,
+}
+
+impl Instance {
+    /// Load and start a copy of `libr3.so`.
+    pub fn new() -> io::Result<Instance> {
+        Instance::from_raw(unsafe { rebCreateInstance(ptr::null()) })
+    }
+
+    /// Load and start a copy of the libr3 at `path`.
+    pub fn with_library(path: &str) -> io::Result<Instance> {
+        let path = CString::new(path)
+            .map_err(|e| io::Error::new(io::ErrorKind::InvalidInput, e))?;
+        Instance::from_raw(unsafe { rebCreateInstance(path.as_ptr()) })
+    }
+
+    fn from_raw(raw: *mut REBINST) -> io::Result<Instance> {
+        match NonNull::new(raw) {
+            Some(raw) => Ok(Instance { raw, _thread_bound: PhantomData }),
+            None => {
+                let why = unsafe { CStr::from_ptr(rebInstanceError()) };
+                Err(io::Error::new(io::ErrorKind::Other, why.to_string_lossy().into_owned()))
+            }
+        }
+    }
+
+    /// Send this thread's API calls here until the guard is dropped, which
+    /// goes back to whatever was entered before.
+    ///
+    /// # Safety
+    ///
+    /// Anything made from the interpreter while entered (`Value`s and the
+    /// like) must be dropped before the guard is, as `run()` makes sure of.
+    pub unsafe fn enter(&self) -> Entered<'_> {
+        let previous = unsafe { rebEnterInstance(self.raw.as_ptr()) };
+        Entered { previous, _instance: PhantomData }
+    }
+
+    /// Run `f` with this instance entered.  Being `Send`, `f` can't bring
+    /// in values of another interpreter, and its result can't take out any
+    /// of this one's.
+    ///
+    /// # Soundness
+    ///
+    /// This is a safe fn with a hole in it: `Send` only covers what `f`
+    /// captures and returns, and `f` can still reach a thread-local.  A
+    /// `Value` (or anything else holding interpreter memory) that `f`
+    /// stashes in one, or takes out of one, crosses interpreters; and once
+    /// the instance is dropped, that `Value`'s handle dangles, and using or
+    /// dropping it is undefined behavior.  Handles don't record which
+    /// interpreter they came from, so nothing checks for this: callers
+    /// must never keep values of any interpreter in thread-locals (or other
+    /// `'static` storage reachable from `f`).
+    pub fn run<R: Send, F: FnOnce() -> R + Send>(&self, f: F) -> R {
+        let _entered = unsafe { self.enter() };
+        f()
+    }
+}
+
+impl Drop for Instance {
+    /// Shuts the instance down.  Nothing made in `run()` can have outlived
+    /// it, short of the thread-local hole described on `run()`.
+    fn drop(&mut self) {
+        unsafe { rebDestroyInstance(self.raw.as_ptr()) }
+    }
+}
+
+pub struct Entered<'a> {
+    previous: *mut REBINST,
+    _instance: PhantomData<&'a Instance>,
+}
+
+impl<'a> Drop for Entered<'a> {
+    fn drop(&mut self) {
+        unsafe { rebEnterInstance(self.previous) };
+    }
+}
@@ -4,6 +4,28 @@
 
 include!(concat!(env!("OUT_DIR"), "/bindings.rs"));
 
+pub mod arena;
+pub mod buffer;
+pub mod bundle;
+pub mod checkpoint;
+pub mod codec;
+pub mod continuation;
+pub mod evaluator;
+pub mod feed;
+pub mod instance;
+#[cfg(unix)]
+pub mod pool;
+pub mod prepared;
+pub mod session;
+pub mod shutdown;
+pub mod value;
+pub mod view;
+
+pub use buffer::RebBuffer;
+pub use evaluator::{Evaluation, Evaluator};
+pub use value::{Value, ValueRef};
+pub use view::{BinaryView, TextView};
+
 #[cfg(test)]
 mod tests {
     use super::*;
@@ -11,8 +33,19 @@ mod tests {
     use std::os::raw::c_void;
     use std::ffi::CString;
 
+    /// Tests take turns holding this.  The interpreter is global to the
+    /// process, and some tests fork, which only carries the forking thread
+    /// over into the child: any lock another test's thread held then (in
+    /// the allocator, say) would stay held there for good.
+    static SERIAL: std::sync::Mutex<()> = std::sync::Mutex::new(());
+
+    fn serial() -> std::sync::MutexGuard<'static, ()> {
+        SERIAL.lock().unwrap_or_else(|e| e.into_inner()) // a failed test poisons it
+    }
+
     #[test]
     fn startup () {
+        let _serial = serial();
         unsafe {
             rebStartup();
             let one: *mut Reb_Value = rebInteger(1i64);
@@ -26,6 +59,7 @@ mod tests {
 
     #[test]
     fn one_plus_one() {
+        let _serial = serial();
         unsafe {
             RL_rebStartup();
             let one: *mut Reb_Value = rebInteger(1i64);
@@ -40,4 +74,575 @@ mod tests {
             RL_rebShutdown(true);
         }
     }
+
+    #[test]
+    fn one_plus_one_array() {
+        let _serial = serial();
+        unsafe {
+            rebStartup();
+            let one: *mut Reb_Value = rebInteger(1i64);
+
+            let expr = b"1 +\0";
+            let two = feed::value(&[expr.as_ptr() as *const c_void, one as *const c_void]);
+            assert_eq!(2, feed::unbox_integer(&[two as *const c_void]));
+            rebRelease(two);
+            rebRelease(one);
+
+            rebShutdown(true);
+        }
+    }
+
+    #[test]
+    fn one_plus_one_prepared() {
+        let _serial = serial();
+        unsafe {
+            rebStartup();
+            let one: *mut Reb_Value = rebInteger(1i64);
+            {
+                let add_one = prepared::Prepared::new(&["1 +", ""]);
+                for _ in 0..3 {
+                    let two = add_one.run(&[one]);
+                    assert_eq!(2, rebUnboxInteger0(two as *const c_void));
+                    rebRelease(two);
+                }
+            }
+            rebRelease(one);
+
+            rebShutdown(true);
+        }
+    }
+
+    #[test]
+    fn prepared_differs_from_feed() {
+        let _serial = serial();
+        unsafe { rebStartup() };
+        {
+            let one = Value::integer(1);
+            let run = |fragments: &[&str], args: &[*const Reb_Value]| unsafe {
+                let prepared = prepared::Prepared::new(fragments);
+                Value::from_raw(prepared.run(args))
+            };
+
+            let block = run(&["reduce [", "]"], &[one.as_ptr()]).unwrap();
+            assert!(reb_did!("[1] =", block));
+
+            let block = run(&["[", "]"], &[one.as_ptr()]).unwrap();
+            assert!(reb_did!("[rebslot-1] =", block));
+
+            let ten = run(&["if true [return 10] 20"], &[]).unwrap();
+            assert_eq!(10, ten.to_i64());
+
+            run(&["prepared-local: 30"], &[]);
+            assert!(reb_did!("not set? 'prepared-local"));
+        }
+        unsafe { rebShutdown(true) };
+    }
+
+    #[test]
+    fn session() {
+        let _serial = serial();
+        unsafe {
+            rebStartup();
+            {
+                let s = session::Session::enter();
+                let one = s.integer(1);
+                assert_eq!(1, s.unbox_integer(one));
+                s.release(one);
+            }
+            rebShutdown(true);
+        }
+    }
+
+    #[test]
+    fn arena() {
+        let _serial = serial();
+        unsafe {
+            rebStartup();
+            let kept;
+            {
+                let arena = arena::Arena::open();
+                for i in 0..100 {
+                    rebInteger(i);
+                }
+                let released = rebInteger(1i64);
+                rebRelease(released);
+                kept = arena.keep(rebInteger(1020i64));
+            }
+            assert_eq!(1020, rebUnboxInteger0(kept as *const c_void));
+            arena::release_many(&[kept]);
+            rebShutdown(true);
+        }
+    }
+
+    #[test]
+    fn values() {
+        let _serial = serial();
+        unsafe { rebStartup() };
+        {
+            let one = Value::integer(1);
+            assert_eq!(1, one.to_i64());
+            assert_eq!(1.5, Value::decimal(1.5).to_f64());
+            assert_eq!("hello", Value::text("hello").to_string());
+            assert!(Value::logic(true).to_bool());
+            assert!(!Value::blank().to_bool());
+
+            let raw = one.into_raw();
+            let one = unsafe { Value::from_raw(raw) }.unwrap();
+            assert_eq!(1, one.borrow().to_i64());
+        }
+        unsafe { rebShutdown(true) };
+    }
+
+    #[test]
+    fn reb_macros() {
+        let _serial = serial();
+        unsafe { rebStartup() };
+        {
+            let one = Value::integer(1);
+            let two = reb!("1 +", one).unwrap();
+            assert_eq!(2, two.to_i64());
+            assert!(reb_did!("2 =", two.borrow()));
+            assert!(reb!("null").is_none());
+            reb_elide!("x: 10 +", &one, "+", 2);
+            assert_eq!(13, reb!("x").unwrap().to_i64());
+        }
+        unsafe { rebShutdown(true) };
+    }
+
+    #[test]
+    fn sized_fragments() {
+        let _serial = serial();
+        unsafe { rebStartup() };
+        {
+            let script = String::from("10 + 20 + 30");
+            let ten = Value::integer(10);
+            let sum = reb!(feed::Fragment::new(&script[..7]), "+", ten).unwrap();
+            assert_eq!(40, sum.to_i64());
+
+            let frag = feed::Fragment::new(&script);
+            let sum = unsafe { feed::unbox_integer(&[feed::FeedItem::feed_ptr(&frag)]) };
+            assert_eq!(60, sum);
+        }
+        unsafe { rebShutdown(true) };
+    }
+
+    #[test]
+    fn spell_and_bytes_into() {
+        let _serial = serial();
+        unsafe { rebStartup() };
+        {
+            let mut text = String::with_capacity(4);
+            Value::text("hello world").spell_into(&mut text);
+            assert_eq!("hello world", text);
+            Value::text("bye").spell_into(&mut text);
+            assert_eq!("bye", text);
+
+            let mut bytes = Vec::new();
+            let expr = b"to binary! {abc}\0";
+            unsafe { feed::bytes_into(&mut bytes, &[expr.as_ptr() as *const c_void]) };
+            assert_eq!(b"abc", &bytes[..]);
+        }
+        unsafe { rebShutdown(true) };
+    }
+
+    #[test]
+    fn views() {
+        let _serial = serial();
+        unsafe { rebStartup() };
+        {
+            let text = Value::text("hello");
+            {
+                let view = unsafe { text.text_view() }.unwrap();
+                assert_eq!("hello", &*view);
+                assert!(unsafe { text.binary_view() }.is_none());
+                // protected while the view is open
+                assert!(reb_did!("protected?", &text));
+            }
+            assert!(!reb_did!("protected?", &text));
+
+            // views of one series can be dropped in any order
+            let first = unsafe { text.text_view() }.unwrap();
+            let second = unsafe { text.text_view() }.unwrap();
+            drop(first);
+            assert!(reb_did!("protected?", &text));
+            assert_eq!("hello", &*second);
+            drop(second);
+            assert!(!reb_did!("protected?", &text));
+
+            let bin = Value::binary(b"\x01\x02\x03");
+            assert_eq!(&[1u8, 2, 3][..], &*unsafe { bin.binary_view() }.unwrap());
+            assert!(unsafe { Value::integer(1).text_view() }.is_none());
+        }
+        unsafe { rebShutdown(true) };
+    }
+
+    #[test]
+    fn rebmalloc_buffer() {
+        let _serial = serial();
+        use std::io::Write;
+
+        unsafe { rebStartup() };
+        {
+            let mut buf = RebBuffer::new();
+            write!(buf, "{}", "abc").unwrap();
+            buf.extend(b"def".iter().cloned());
+            assert_eq!(b"abcdef", &buf[..]);
+
+            let bin = buf.into_binary();
+            assert!(reb_did!("#{616263646566} = ", &bin));
+            assert_eq!(0, reb!("length of", RebBuffer::new().into_binary()).unwrap().to_i64());
+        }
+        unsafe { rebShutdown(true) };
+    }
+
+    #[test]
+    fn foreign_handles() {
+        let _serial = serial();
+        use std::sync::Arc;
+
+        struct Owner {
+            bytes: Vec<u8>,
+            _alive: Arc<()>,
+        }
+        impl AsRef<[u8]> for Owner {
+            fn as_ref(&self) -> &[u8] {
+                &self.bytes
+            }
+        }
+
+        unsafe { rebStartup() };
+        {
+            let alive = Arc::new(());
+            let handle = Value::handle(Owner { bytes: vec![1, 2, 3], _alive: alive.clone() });
+            let data = handle.handle_bytes().unwrap().as_ptr();
+            assert_eq!(&[1u8, 2, 3][..], handle.handle_bytes().unwrap());
+            assert_eq!(data, handle.handle_bytes().unwrap().as_ptr());
+            assert!(Value::integer(1).handle_bytes().is_none());
+
+            drop(handle);
+            reb_elide!("recycle");
+            assert_eq!(1, Arc::strong_count(&alive));
+        }
+        unsafe { rebShutdown(true) };
+    }
+
+    #[test]
+    fn streaming_codecs() {
+        let _serial = serial();
+        use std::io::{Read, Write};
+        use codec::{Decoder, Encoder, Format};
+
+        let input: Vec<u8> = (0..1_000_000u32).map(|i| (i % 251) as u8 ^ (i / 4096) as u8).collect();
+        for &format in &[Format::Deflate, Format::Zlib, Format::Gzip] {
+            let mut enc = Encoder::new(Vec::new(), format, 6).unwrap();
+            for chunk in input.chunks(10_000) {
+                enc.write_all(chunk).unwrap();
+            }
+            let compressed = enc.finish().unwrap();
+            assert!(compressed.len() < input.len());
+
+            let mut output = Vec::new();
+            Decoder::new(&compressed[..], format).unwrap().read_to_end(&mut output).unwrap();
+            assert!(output == input);
+
+            let mut truncated = Decoder::new(&compressed[..compressed.len() / 2], format).unwrap();
+            assert!(truncated.read_to_end(&mut Vec::new()).is_err());
+        }
+
+        // Runs, read a byte at a time: the codec takes the last of the input
+        // while the match it ends with is still being copied out
+        for len in 1..100 {
+            let zeros = vec![0u8; len];
+            let mut enc = Encoder::new(Vec::new(), Format::Deflate, 9).unwrap();
+            enc.write_all(&zeros).unwrap();
+            let compressed = enc.finish().unwrap();
+            let mut dec = Decoder::new(&compressed[..], Format::Deflate).unwrap();
+            let mut output = Vec::new();
+            let mut byte = [0u8; 1];
+            while dec.read(&mut byte).unwrap() == 1 {
+                output.push(byte[0]);
+            }
+            assert!(output == zeros);
+        }
+    }
+
+    #[test]
+    fn parallel_gzip() {
+        let _serial = serial();
+        use std::io::Read;
+        use codec::{Decoder, Format, ParallelGzip};
+
+        let input: Vec<u8> = (0..300_000u32).map(|i| (i % 251) as u8 ^ (i / 4096) as u8).collect();
+        for &(threads, size) in &[(1, 0), (4, 5), (4, 4096), (3, input.len())] {
+            let gzip = ParallelGzip::new().threads(threads).block_size(4096);
+            let compressed = gzip.compress(&input[..size]).unwrap();
+
+            let mut output = Vec::new();
+            Decoder::new(&compressed[..], Format::Gzip).unwrap().read_to_end(&mut output).unwrap();
+            assert!(output == &input[..size]);
+        }
+    }
+
+    #[test]
+    fn compress_into() {
+        let _serial = serial();
+        use codec::{Codec, Format, Strategy};
+
+        let message = b"GET /status HTTP/1.1\r\nHost: localhost\r\n\r\n".repeat(4);
+        let mut compressor = Codec::compressor_with(Format::Deflate, 1, Strategy::Default).unwrap();
+        let mut decompressor = Codec::decompressor(Format::Deflate).unwrap();
+        let mut packed = vec![0; compressor.compress_bound(message.len())];
+        let mut unpacked = vec![0; message.len()];
+
+        for _ in 0..3 {
+            let size = compressor.compress_into(&message, &mut packed).unwrap();
+            let n = decompressor.decompress_into(&packed[..size], &mut unpacked).unwrap();
+            assert_eq!(&message[..], &unpacked[..n]);
+
+            assert!(decompressor.decompress_into(&packed[..size], &mut unpacked[..10]).is_err());
+            assert!(decompressor.decompress_into(&packed[..size / 2], &mut unpacked).is_err());
+        }
+        assert!(compressor.compress_into(&message, &mut packed[..4]).is_err());
+
+        compressor.set_params(9, Strategy::Rle).unwrap();
+        let size = compressor.compress_into(&message, &mut packed).unwrap();
+        let n = decompressor.decompress_into(&packed[..size], &mut unpacked).unwrap();
+        assert_eq!(&message[..], &unpacked[..n]);
+    }
+
+    #[test]
+    fn preset_dictionary() {
+        let _serial = serial();
+        use codec::{Codec, Dictionary, Format};
+
+        let dict = Dictionary::new(br#"{"user": "", "action": "login", "status": "ok"}"#).unwrap();
+        let message = br#"{"user": "alice", "action": "login", "status": "ok"}"#;
+
+        for &format in &[Format::Deflate, Format::Zlib] {
+            let mut plain = Codec::compressor(format, 9).unwrap();
+            let mut primed = Codec::compressor(format, 9).unwrap();
+            primed.set_dictionary(Some(dict.clone())).unwrap();
+
+            let mut packed = vec![0; 256];
+            let plain_size = plain.compress_into(message, &mut packed).unwrap();
+            let size = primed.compress_into(message, &mut packed).unwrap();
+            assert!(size < plain_size);
+
+            let mut unpacked = vec![0; 256];
+            let mut decompressor = Codec::decompressor(format).unwrap();
+            decompressor.set_dictionary(Some(dict.clone())).unwrap();
+            let n = decompressor.decompress_into(&packed[..size], &mut unpacked).unwrap();
+            assert_eq!(&message[..], &unpacked[..n]);
+        }
+
+        let mut gzip = Codec::compressor(Format::Gzip, 6).unwrap();
+        assert!(gzip.set_dictionary(Some(dict)).is_err());
+    }
+
+    #[test]
+    fn decompress_detect() {
+        let _serial = serial();
+        use codec::{Codec, Format};
+
+        let data = b"detect me, detect me, detect me".repeat(50);
+        unsafe { rebStartup() };
+        for &format in &[Format::Deflate, Format::Zlib, Format::Gzip] {
+            let mut packed = vec![0; 2048];
+            let mut compressor = Codec::compressor(format, -1).unwrap();
+            let size = compressor.compress_into(&data, &mut packed).unwrap();
+            packed.truncate(size);
+
+            let (out, detected) = codec::decompress(&packed, None, 0);
+            assert_eq!(format, detected);
+            assert_eq!(&data[..], &out[..]);
+
+            let (out, _) = codec::decompress(&packed, Some(detected), data.len());
+            assert_eq!(&data[..], &out[..]);
+        }
+        unsafe { rebShutdown(true) };
+    }
+
+    #[test]
+    fn checkpoint_reset() {
+        let _serial = serial();
+        unsafe { rebStartup() };
+        assert!(!checkpoint::reset());
+
+        reb_elide!("a: b: [1 2] changed: 10 grow: func [] [append [] 1]");
+        checkpoint::checkpoint();
+        for _ in 0..2 {
+            reb_elide!("a: [3] b: 4 changed: 20 added: 30 grow");
+            assert!(checkpoint::reset());
+            assert!(reb_did!("all [same? a b  a = [1 2]]"));
+            assert_eq!(10, reb!("changed").unwrap().to_i64());
+            assert!(reb_did!("not set? 'added"));
+        }
+        assert_eq!(3, reb!("length of grow").unwrap().to_i64()); // not rolled back
+        unsafe { rebShutdown(true) };
+    }
+
+    #[test]
+    fn continuations_take_turns() {
+        let _serial = serial();
+        unsafe { rebStartup() };
+        let mut a = continuation::Continuation::new("x: 1 x: x + 1 x: x * 10 x + 1");
+        let mut b = continuation::Continuation::new("y: 0 loop 3 [y: y + 1] y");
+        let mut resumes = 0;
+        let (mut a_done, mut b_done) = (false, false);
+        while !(a_done && b_done) {
+            assert!(a.result().is_none() || a_done);
+            a_done = a.resume(1);
+            b_done = b.resume(1);
+            resumes += 1;
+        }
+        assert!(resumes > 1);
+        assert_eq!(21, a.result().unwrap().to_i64());
+        assert_eq!(3, b.result().unwrap().to_i64());
+
+        let mut empty = continuation::Continuation::new("");
+        assert!(empty.finish().is_none());
+        drop((a, b, empty));
+        unsafe { rebShutdown(true) };
+    }
+
+    #[test]
+    fn async_evaluation() {
+        let _serial = serial();
+        let evaluator = Evaluator::start(1);
+        let mut long = String::from("n: 0");
+        for _ in 0..20000 {
+            long.push_str(" n: n + 1");
+        }
+        long.push_str(" reduce [n flag]");
+
+        // Sent second, but done first: the long one runs in slices, and
+        // only gets to its end after the short one has set `flag`
+        let long = evaluator.eval(&long);
+        let short = evaluator.eval("flag: 1 + 2");
+        assert_eq!("3", evaluator::block_on(short).unwrap());
+        assert_eq!("[20000 3]", evaluator::block_on(long).unwrap());
+
+        let failed = evaluator::block_on(evaluator.eval("fail {boom}")).unwrap_err();
+        assert!(failed.to_string().contains("boom"));
+        assert!(evaluator::block_on(evaluator.eval("1 + [")).is_err());
+        assert_eq!("", evaluator::block_on(evaluator.eval("null")).unwrap());
+
+        // Skipped if dropped before its first slice; once started, this
+        // one expression runs to its end, as it can't be cut short
+        drop(evaluator.eval("loop 1000000 [1]"));
+    }
+
+    #[test]
+    #[cfg(unix)]
+    fn fast_shutdown_keeps_output() {
+        let _serial = serial();
+        use std::io::{Read, Write};
+        use std::os::unix::io::FromRawFd;
+
+        let file = std::env::temp_dir().join("renc-fast-exit.txt");
+        let _ = std::fs::remove_file(&file);
+
+        // In a child, so the fast exit can be the end of a process, with
+        // its stdout going to a pipe instead of a (line-buffered) terminal
+        let mut fds = [0; 2];
+        assert_eq!(0, unsafe { libc::pipe(fds.as_mut_ptr()) });
+        let pid = unsafe { libc::fork() };
+        if pid == 0 {
+            // A panic mustn't unwind into a copy of the test harness
+            let ran = std::panic::catch_unwind(std::panic::AssertUnwindSafe(|| {
+                unsafe {
+                    libc::dup2(fds[1], 1);
+                    libc::close(fds[0]);
+                    rebStartup();
+                }
+                reb_elide!("repeat i 1000 [print i]");
+                reb_elide!("write to file!", Value::text(file.to_str().unwrap()), "{port data}");
+                std::io::stdout().write_all(b"rust tail").unwrap(); // not print!(), which tests capture
+                unsafe { libc::printf(b"c tail\0".as_ptr() as *const libc::c_char) };
+                shutdown::fast();
+            }));
+            unsafe { libc::_exit(if ran.is_ok() { 0 } else { 1 }) } // skipping atexit, so no flushing there
+        }
+
+        unsafe { libc::close(fds[1]) };
+        let mut output = String::new();
+        unsafe { std::fs::File::from_raw_fd(fds[0]) }.read_to_string(&mut output).unwrap();
+        let mut status = 0;
+        assert_eq!(pid, unsafe { libc::waitpid(pid, &mut status, 0) });
+        assert!(libc::WIFEXITED(status) && libc::WEXITSTATUS(status) == 0, "child status {:#x}", status);
+
+        assert!(output.starts_with("1\n2\n"));
+        assert!(output.contains("\n1000\n"));
+        assert!(output.contains("rust tail"));
+        assert!(output.contains("c tail"));
+        assert_eq!("port data", std::fs::read_to_string(&file).unwrap());
+    }
+
+    #[test]
+    fn script_bundle() {
+        let _serial = serial();
+        let dir = std::env::temp_dir();
+        let script = dir.join("renc-bundle-test.r");
+        let path = dir.join("renc-bundle-test.bdl");
+        std::fs::write(&script, "bundle-answer: 6 * 7").unwrap();
+        bundle::save(&path, &[&script]).unwrap();
+
+        bundle::startup(&path).unwrap();
+        assert_eq!(42, reb!("bundle-answer").unwrap().to_i64());
+        unsafe { rebShutdown(true) };
+
+        assert!(bundle::startup(&script).is_err()); // not a bundle
+        unsafe { rebShutdown(true) };
+    }
+
+    #[test]
+    #[cfg(unix)]
+    fn prefork_pool() {
+        let _serial = serial();
+        use pool::Pool;
+
+        assert!(Pool::start(0, "").is_err());
+
+        let pool = Pool::start(2, "double: func [x] [x * 2]").unwrap();
+        assert_eq!("42", pool.run("double 21").unwrap());
+        assert!(pool.run("double {x}").is_err());
+
+        let before = pool.pids();
+        unsafe {
+            libc::kill(before[0], libc::SIGKILL);
+            // dead for sure (and its socket closed), but left to the pool to reap
+            let mut info: libc::siginfo_t = std::mem::zeroed();
+            libc::waitid(libc::P_PID, before[0] as libc::id_t, &mut info, libc::WEXITED | libc::WNOWAIT);
+        }
+        for _ in 0..4 {
+            assert_eq!("[2 4]", pool.run("reduce [double 1 double 2]").unwrap());
+        }
+        assert_ne!(before[0], pool.pids()[0]);
+    }
+
+    #[test]
+    #[cfg(feature = "instances")]
+    fn instances() {
+        let _serial = serial();
+        use instance::Instance;
+        use std::sync::{Arc, Barrier};
+
+        let barrier = Arc::new(Barrier::new(4));
+        let workers: Vec<_> = (0..4i64)
+            .map(|i| {
+                let barrier = barrier.clone();
+                std::thread::spawn(move || {
+                    let instance = Instance::new().unwrap();
+                    instance.run(|| {
+                        reb_elide!("shared: 100 *", Value::integer(i));
+                        barrier.wait(); // all have set it before any reads
+                        reb!("shared + 1").unwrap().to_i64()
+                    })
+                })
+            })
+            .collect();
+        for (i, worker) in workers.into_iter().enumerate() {
+            assert_eq!(100 * i as i64 + 1, worker.join().unwrap());
+        }
+    }
 }
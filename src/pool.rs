@@ -0,0 +1,325 @@
+//! A prefork pool of interpreter processes (Unix only).
+//!
+//! `rebStartup()` is expensive, and the interpreter is global to the
+//! process.  `Pool::start()` boots it once, runs a preload script, then
+//! forks the workers, which share the booted heap copy-on-write, so each
+//! costs only a fork.  Scripts go to an idle worker over a socket, as
+//! UTF-8 text, and the result comes back MOLDed.  A worker is checked
+//! before a script goes to it, and forked again if it has died.  A worker
+//! acknowledges a script before running it, so if one dies so shortly
+//! before that it still looked alive, the script is known not to have run,
+//! and is sent again (once) to the new one.  A worker that dies while
+//! running a script is forked again too, and the script fails.
+//!
+//! The interpreter is booted, and every worker forked, on a thread of the
+//! pool's own, which does nothing else: a fork only carries over the
+//! thread that made it, so that's the one thread that must not be in the
+//! middle of something.  The parent's interpreter isn't otherwise used
+//! once the pool is started, and nothing else in the process may use it
+//! meanwhile.  The pool can be shared between threads; each `run()` has a
+//! worker to itself.
+//!
+//! Writes to a worker that has died give `EPIPE` rather than raising
+//! SIGPIPE, which would kill the whole process unless it's ignored.
+
+use crate::*;
+use std::io::{self, Read};
+use std::os::raw::c_void;
+use std::os::unix::io::{AsRawFd, RawFd};
+use std::os::unix::net::UnixStream;
+use std::sync::atomic::{AtomicUsize, Ordering};
+use std::sync::mpsc::{self, Receiver, Sender};
+use std::sync::Mutex;
+use std::thread::{self, JoinHandle};
+
+struct Worker {
+    slot: usize,
+    pid: libc::pid_t,
+    socket: UnixStream,
+}
+
+impl Worker {
+    /// An idle worker never writes first, so if its socket has anything to
+    /// read, that's the end of it: the worker has exited.
+    fn is_alive(&self) -> bool {
+        let mut poll = libc::pollfd {
+            fd: self.socket.as_raw_fd(),
+            events: libc::POLLIN,
+            revents: 0,
+        };
+        let ready = unsafe { libc::poll(&mut poll, 1, 0) };
+        ready != 1
+    }
+}
+
+pub struct Pool {
+    workers: Vec<Mutex<Worker>>,
+    forker: Option<Mutex<Forker>>,
+    thread: Option<JoinHandle<()>>,
+    next: AtomicUsize,
+}
+
+/// The way to the forking thread: send it a slot, and it sends back a
+/// worker for it (one at a time, hence the mutex around this).
+struct Forker {
+    slots: Sender<usize>,
+    workers: Receiver<io::Result<Worker>>,
+}
+
+impl Pool {
+    /// Boot the interpreter, run `preload` (e.g. a `do %file` of the
+    /// scripts the workers need), and fork `size` workers, at least one.
+    /// The pool owns the interpreter, and shuts it down when dropped.
+    pub fn start(size: usize, preload: &str) -> io::Result<Pool> {
+        if size == 0 {
+            return Err(io::Error::new(io::ErrorKind::InvalidInput, "a pool needs a worker"));
+        }
+
+        let (slots, received) = mpsc::channel();
+        let (forked, workers) = mpsc::channel();
+        let preload = preload.to_owned();
+        let thread = thread::Builder::new()
+            .name("renc-pool".into())
+            .spawn(move || fork_workers(size, &preload, received, forked))?;
+
+        let mut pool = Pool {
+            workers: Vec::with_capacity(size),
+            forker: Some(Mutex::new(Forker { slots, workers })),
+            thread: Some(thread),
+            next: AtomicUsize::new(0),
+        };
+        for slot in 0..size {
+            let worker = pool.spawn(slot)?;
+            pool.workers.push(Mutex::new(worker));
+        }
+        Ok(pool)
+    }
+
+    pub fn size(&self) -> usize {
+        self.workers.len()
+    }
+
+    /// Process IDs of the workers, as of now.
+    pub fn pids(&self) -> Vec<libc::pid_t> {
+        self.workers.iter().map(|w| w.lock().unwrap().pid).collect()
+    }
+
+    /// Evaluate `script` in a worker, giving the MOLD of its result.  A
+    /// Rebol error comes back as an `Other` error with the error's text;
+    /// if the worker dies while running it, the error is `BrokenPipe`.
+    pub fn run(&self, script: &str) -> io::Result<String> {
+        let mut worker = self.idle_worker();
+        if !worker.is_alive() {
+            self.replace(&mut worker)?; // died since it was last used
+        }
+
+        // Not taken, the script hasn't run, so it can go to a new worker.
+        let mut sent = Self::send(&mut worker, script.as_bytes());
+        if sent.is_err() {
+            self.replace(&mut worker)?;
+            sent = Self::send(&mut worker, script.as_bytes());
+        }
+
+        let reply = sent.and_then(|()| Self::receive(&mut worker));
+        match reply {
+            Ok((true, text)) => Ok(String::from_utf8_lossy(&text).into_owned()),
+            Ok((false, text)) => Err(io::Error::new(
+                io::ErrorKind::Other,
+                String::from_utf8_lossy(&text).into_owned(),
+            )),
+            Err(_) => {
+                self.replace(&mut worker)?;
+                Err(io::Error::new(io::ErrorKind::BrokenPipe, "pool worker died"))
+            }
+        }
+    }
+
+    /// The first worker that isn't busy, else wait for one in turn.
+    fn idle_worker(&self) -> std::sync::MutexGuard<'_, Worker> {
+        let start = self.next.fetch_add(1, Ordering::Relaxed);
+        let n = self.workers.len();
+        for i in 0..n {
+            if let Ok(worker) = self.workers[(start + i) % n].try_lock() {
+                return worker;
+            }
+        }
+        self.workers[start % n].lock().unwrap()
+    }
+
+    /// Send a request, and wait for the worker to say it has taken it.
+    fn send(worker: &mut Worker, request: &[u8]) -> io::Result<()> {
+        write_frame(&worker.socket, request)?;
+        let mut taken = [0u8; 1];
+        worker.socket.read_exact(&mut taken)
+    }
+
+    /// Whether the script succeeded, and its result or error.
+    fn receive(worker: &mut Worker) -> io::Result<(bool, Vec<u8>)> {
+        let mut ok = [0u8; 1];
+        worker.socket.read_exact(&mut ok)?;
+        Ok((ok[0] != 0, read_frame(&mut worker.socket)?))
+    }
+
+    /// Kill `worker` (if it isn't dead already), and fork another in its
+    /// slot.
+    fn replace(&self, worker: &mut Worker) -> io::Result<()> {
+        let mut status = 0;
+        unsafe {
+            libc::kill(worker.pid, libc::SIGKILL);
+            libc::waitpid(worker.pid, &mut status, 0);
+        }
+        *worker = self.spawn(worker.slot)?;
+        Ok(())
+    }
+
+    /// Have the forking thread fork a worker for `slot`.
+    fn spawn(&self, slot: usize) -> io::Result<Worker> {
+        let gone = || io::Error::new(io::ErrorKind::BrokenPipe, "pool thread is gone");
+        let forker = self.forker.as_ref().unwrap().lock().unwrap();
+        forker.slots.send(slot).map_err(|_| gone())?;
+        forker.workers.recv().unwrap_or_else(|_| Err(gone()))
+    }
+}
+
+impl Drop for Pool {
+    fn drop(&mut self) {
+        for worker in self.workers.drain(..) {
+            let worker = worker.into_inner().unwrap_or_else(|e| e.into_inner());
+            let mut status = 0;
+            unsafe {
+                libc::kill(worker.pid, libc::SIGKILL);
+                libc::waitpid(worker.pid, &mut status, 0);
+            }
+        }
+        self.forker = None; // so the thread sees the end of the slots
+        if let Some(thread) = self.thread.take() {
+            let _ = thread.join();
+        }
+    }
+}
+
+/// The forking thread: boot the interpreter, then fork a worker for each
+/// slot it's sent, until the pool is dropped.
+fn fork_workers(
+    size: usize,
+    preload: &str,
+    slots: Receiver<usize>,
+    forked: Sender<io::Result<Worker>>,
+) {
+    unsafe { rebStartup() };
+    if !preload.is_empty() {
+        reb_elide!("do", Value::text(preload));
+    }
+
+    // The parent's socket of each worker, for each new worker to close its
+    // copies of (so a worker sees EOF when the parent goes away)
+    let mut sockets: Vec<RawFd> = vec![-1; size];
+    for slot in slots {
+        let _ = forked.send(fork_worker(slot, &mut sockets));
+    }
+
+    unsafe { rebShutdown(true) };
+}
+
+fn fork_worker(slot: usize, sockets: &mut [RawFd]) -> io::Result<Worker> {
+    let (parent, child) = UnixStream::pair()?;
+    no_sigpipe(&parent)?;
+    no_sigpipe(&child)?;
+
+    match unsafe { libc::fork() } {
+        -1 => Err(io::Error::last_os_error()),
+        0 => {
+            // Every worker's, including the one this replaces, if any
+            for &fd in sockets.iter().filter(|&&fd| fd >= 0) {
+                unsafe { libc::close(fd) };
+            }
+            drop(parent);
+            let code = match std::panic::catch_unwind(|| serve(child)) {
+                Ok(()) => 0,
+                Err(_) => 1,
+            };
+            unsafe { libc::_exit(code) } // no atexit handlers, no unwinding
+        }
+        pid => {
+            drop(child);
+            sockets[slot] = parent.as_raw_fd();
+            Ok(Worker { slot, pid, socket: parent })
+        }
+    }
+}
+
+/// A worker's loop: run each script it's sent until the parent hangs up.
+fn serve(mut socket: UnixStream) {
+    while let Ok(script) = read_frame(&mut socket) {
+        // Taken: from here on, the parent won't send it anywhere else
+        if send_all(&socket, &[1]).is_err() {
+            return;
+        }
+        let script = Value::text(&String::from_utf8_lossy(&script));
+        let error = reb!("trap [pool-result: mold do", script, "]");
+        let (ok, text) = match error {
+            None => (true, reb!("pool-result").unwrap().to_string()),
+            Some(error) => (false, reb!("form", error).unwrap().to_string()),
+        };
+        if send_all(&socket, &[ok as u8]).is_err() || write_frame(&socket, text.as_bytes()).is_err() {
+            return;
+        }
+    }
+}
+
+// Sockets are written with send(), which can be told not to raise
+// SIGPIPE; Apple's can't, but the socket can be set up not to.
+
+#[cfg(not(any(target_os = "macos", target_os = "ios")))]
+const SEND_FLAGS: libc::c_int = libc::MSG_NOSIGNAL;
+#[cfg(any(target_os = "macos", target_os = "ios"))]
+const SEND_FLAGS: libc::c_int = 0;
+
+#[cfg(not(any(target_os = "macos", target_os = "ios")))]
+fn no_sigpipe(_socket: &UnixStream) -> io::Result<()> {
+    Ok(())
+}
+
+#[cfg(any(target_os = "macos", target_os = "ios"))]
+fn no_sigpipe(socket: &UnixStream) -> io::Result<()> {
+    let on: libc::c_int = 1;
+    let size = std::mem::size_of::<libc::c_int>() as libc::socklen_t;
+    let fd = socket.as_raw_fd();
+    let set = &on as *const libc::c_int as *const c_void;
+    if unsafe { libc::setsockopt(fd, libc::SOL_SOCKET, libc::SO_NOSIGPIPE, set, size) } != 0 {
+        return Err(io::Error::last_os_error());
+    }
+    Ok(())
+}
+
+fn send_all(socket: &UnixStream, mut bytes: &[u8]) -> io::Result<()> {
+    while !bytes.is_empty() {
+        let n = unsafe {
+            libc::send(socket.as_raw_fd(), bytes.as_ptr() as *const c_void, bytes.len(), SEND_FLAGS)
+        };
+        if n < 0 {
+            let error = io::Error::last_os_error();
+            if error.kind() == io::ErrorKind::Interrupted {
+                continue;
+            }
+            return Err(error);
+        }
+        bytes = &bytes[n as usize..];
+    }
+    Ok(())
+}
+
+// A frame is a little-endian u32 length, then that many bytes.
+
+fn write_frame(out: &UnixStream, bytes: &[u8]) -> io::Result<()> {
+    send_all(out, &(bytes.len() as u32).to_le_bytes())?;
+    send_all(out, bytes)
+}
+
+fn read_frame(input: &mut UnixStream) -> io::Result<Vec<u8>> {
+    let mut len = [0u8; 4];
+    input.read_exact(&mut len)?;
+    let mut bytes = vec![0; u32::from_le_bytes(len) as usize];
+    input.read_exact(&mut bytes)?;
+    Ok(bytes)
+}
@@ -0,0 +1,61 @@
+//! Prepared evaluations: scan and bind a feed's text once, run it often.
+//!
+//! The shape of a feed like `rebValue("1 +", one, END)` is given as its
+//! fragments, with a slot for a spliced value between each pair of them:
+//! `Prepared::new(&["1 +", ""])`.  Running it supplies the slot values,
+//! and costs only the evaluation.
+//!
+//! The fragments are the body of a function whose arguments are the
+//! slots, which isn't quite a feed (see `rebPrepare()` in
+//! renc/shim/valist.h): a slot in an unevaluated block stays a word
+//! (`["[", "]"]` gives `[rebslot-1]`; `["reduce [", "]"]` gives the
+//! value), a `return` returns from the prepared function, and set-words
+//! are its locals rather than words of the user context.
+
+use crate::*;
+use std::ffi::CString;
+use std::os::raw::c_char;
+
+pub struct Prepared {
+    handle: *mut Reb_Value,
+    num_slots: usize,
+}
+
+impl Prepared {
+    pub unsafe fn new(fragments: &[&str]) -> Prepared {
+        let owned: Vec<CString> = fragments
+            .iter()
+            .map(|f| CString::new(*f).unwrap())
+            .collect();
+        let ptrs: Vec<*const c_char> = owned.iter().map(|f| f.as_ptr()).collect();
+
+        Prepared {
+            handle: rebPrepare(ptrs.as_ptr(), ptrs.len() as size_t),
+            num_slots: fragments.len().saturating_sub(1),
+        }
+    }
+
+    pub fn handle(&self) -> *const Reb_Value {
+        self.handle
+    }
+
+    pub fn num_slots(&self) -> usize {
+        self.num_slots
+    }
+
+    pub unsafe fn run(&self, args: &[*const Reb_Value]) -> *mut Reb_Value {
+        debug_assert_eq!(args.len(), self.num_slots);
+        rebRunPrepared(self.handle, args.as_ptr(), args.len() as size_t)
+    }
+
+    pub unsafe fn elide(&self, args: &[*const Reb_Value]) {
+        debug_assert_eq!(args.len(), self.num_slots);
+        rebElidePrepared(self.handle, args.as_ptr(), args.len() as size_t)
+    }
+}
+
+impl Drop for Prepared {
+    fn drop(&mut self) {
+        unsafe { rebRelease(self.handle) }
+    }
+}
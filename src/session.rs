@@ -0,0 +1,84 @@
+//! API sessions: enter the API once for a run of calls on one thread.
+//!
+//! Each plain shim call does `RL_rebEnterApi_internal()` first.  While a
+//! `Session` is alive, its methods call the shim's `_entered` variants,
+//! which skip that.  Sessions nest, and are tied to the thread that made
+//! them (the type is neither `Send` nor `Sync`).
+
+use crate::*;
+use std::marker::PhantomData;
+use std::os::raw::{c_char, c_void};
+
+pub struct Session {
+    _thread_bound: PhantomData<*const ()>,
+}
+
+impl Session {
+    /// The interpreter must have been started with `rebStartup()`.
+    pub unsafe fn enter() -> Session {
+        rebEnterSession();
+        Session { _thread_bound: PhantomData }
+    }
+
+    pub fn void(&self) -> *mut Reb_Value {
+        unsafe { rebVoid_entered() }
+    }
+
+    pub fn blank(&self) -> *mut Reb_Value {
+        unsafe { rebBlank_entered() }
+    }
+
+    pub fn logic(&self, logic: bool) -> *mut Reb_Value {
+        unsafe { rebLogic_entered(logic) }
+    }
+
+    pub fn integer(&self, i: i64) -> *mut Reb_Value {
+        unsafe { rebInteger_entered(i as int64_t) }
+    }
+
+    pub fn decimal(&self, dec: f64) -> *mut Reb_Value {
+        unsafe { rebDecimal_entered(dec) }
+    }
+
+    pub fn text(&self, utf8: &str) -> *mut Reb_Value {
+        unsafe { rebSizedText_entered(utf8.as_ptr() as *const c_char, utf8.len() as size_t) }
+    }
+
+    pub fn binary(&self, bytes: &[u8]) -> *mut Reb_Value {
+        unsafe { rebSizedBinary_entered(bytes.as_ptr() as *const c_void, bytes.len() as size_t) }
+    }
+
+    pub unsafe fn release(&self, v: *const Reb_Value) {
+        rebRelease_entered(v)
+    }
+
+    pub unsafe fn unbox(&self, v: *const Reb_Value) -> isize {
+        rebUnbox0_entered(v as *const c_void) as isize
+    }
+
+    pub unsafe fn unbox_integer(&self, v: *const Reb_Value) -> i64 {
+        rebUnboxInteger0_entered(v as *const c_void) as i64
+    }
+
+    pub unsafe fn value(&self, items: &[*const c_void]) -> *mut Reb_Value {
+        rebValueArray_entered(items.as_ptr(), items.len() as size_t)
+    }
+
+    pub unsafe fn elide(&self, items: &[*const c_void]) {
+        rebElideArray_entered(items.as_ptr(), items.len() as size_t)
+    }
+
+    pub unsafe fn run(
+        &self,
+        prepared: &prepared::Prepared,
+        args: &[*const Reb_Value],
+    ) -> *mut Reb_Value {
+        rebRunPrepared_entered(prepared.handle(), args.as_ptr(), args.len() as size_t)
+    }
+}
+
+impl Drop for Session {
+    fn drop(&mut self) {
+        unsafe { rebLeaveSession() }
+    }
+}
@@ -0,0 +1,23 @@
+//! Shutting the interpreter down.
+//!
+//! `clean()` frees everything, so the interpreter can be started again.
+//! A process that is about to exit doesn't need that: `fast()` only makes
+//! sure buffered output gets out.  See `rebShutdownFast()` in
+//! renc/shim/valist.h.
+
+use crate::*;
+use std::io::Write;
+
+#[inline]
+pub fn clean() {
+    unsafe { rebShutdown(true) }
+}
+
+/// Flush Rust's and C's output buffers and shut down without tearing
+/// anything down.  Only the process exiting may follow: the interpreter
+/// can't be used or started again.
+pub fn fast() {
+    let _ = std::io::stdout().flush();
+    let _ = std::io::stderr().flush();
+    unsafe { rebShutdownFast() }
+}
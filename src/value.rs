@@ -0,0 +1,270 @@
+//! Owned and borrowed API handles.
+//!
+//! `Value` owns a `REBVAL*` API handle and releases it when dropped, and
+//! `ValueRef` borrows one.  Both are a single pointer wide, and every
+//! method is one shim call, so they cost the same as the raw calls.
+//!
+//! The interpreter is single-threaded, so neither type is `Send` or
+//! `Sync`.  Note that a Rebol error raised inside a call (e.g. `to_i64()`
+//! on something that isn't an INTEGER!) is not turned into a Rust error.
+
+use crate::*;
+use std::marker::PhantomData;
+use std::os::raw::{c_char, c_void};
+use std::ptr::NonNull;
+
+#[repr(transparent)]
+pub struct Value {
+    ptr: NonNull<Reb_Value>,
+    _thread_bound: PhantomData<*const ()>,
+}
+
+#[repr(transparent)]
+#[derive(Clone, Copy)]
+pub struct ValueRef<'a> {
+    ptr: NonNull<Reb_Value>,
+    _borrow: PhantomData<&'a Value>,
+}
+
+impl Value {
+    /// Take ownership of an API handle.  Rebol's null is the null pointer,
+    /// so that gives `None`.
+    #[inline]
+    pub unsafe fn from_raw(ptr: *mut Reb_Value) -> Option<Value> {
+        NonNull::new(ptr).map(|ptr| Value { ptr, _thread_bound: PhantomData })
+    }
+
+    /// Give up ownership without releasing the handle.
+    #[inline]
+    pub fn into_raw(self) -> *mut Reb_Value {
+        let ptr = self.ptr.as_ptr();
+        std::mem::forget(self);
+        ptr
+    }
+
+    #[inline]
+    pub fn as_ptr(&self) -> *const Reb_Value {
+        self.ptr.as_ptr()
+    }
+
+    #[inline]
+    pub fn borrow(&self) -> ValueRef<'_> {
+        ValueRef { ptr: self.ptr, _borrow: PhantomData }
+    }
+
+    #[inline]
+    pub fn void() -> Value {
+        unsafe { Value::from_raw(rebVoid()).unwrap() }
+    }
+
+    #[inline]
+    pub fn blank() -> Value {
+        unsafe { Value::from_raw(rebBlank()).unwrap() }
+    }
+
+    #[inline]
+    pub fn logic(logic: bool) -> Value {
+        unsafe { Value::from_raw(rebLogic(logic)).unwrap() }
+    }
+
+    #[inline]
+    pub fn integer(i: i64) -> Value {
+        unsafe { Value::from_raw(rebInteger(i as int64_t)).unwrap() }
+    }
+
+    #[inline]
+    pub fn decimal(dec: f64) -> Value {
+        unsafe { Value::from_raw(rebDecimal(dec)).unwrap() }
+    }
+
+    #[inline]
+    pub fn text(utf8: &str) -> Value {
+        unsafe {
+            let ptr = rebSizedText(utf8.as_ptr() as *const c_char, utf8.len() as size_t);
+            Value::from_raw(ptr).unwrap()
+        }
+    }
+
+    #[inline]
+    pub fn binary(bytes: &[u8]) -> Value {
+        unsafe {
+            let ptr = rebSizedBinary(bytes.as_ptr() as *const c_void, bytes.len() as size_t);
+            Value::from_raw(ptr).unwrap()
+        }
+    }
+
+    /// HANDLE! over the bytes of `owner` (a `Box<[u8]>`, `Arc<[u8]>`, an
+    /// mmap...), without copying them.  `owner` is dropped when the GC
+    /// collects the handle, on whatever thread that is, hence `Send`.
+    pub fn handle<T: AsRef<[u8]> + Send + 'static>(owner: T) -> Value {
+        unsafe extern "C" fn drop_owner<T>(opaque: *mut c_void) {
+            drop(Box::from_raw(opaque as *mut T));
+        }
+
+        let owner = Box::new(owner);
+        let (data, size) = {
+            let bytes = (*owner).as_ref();
+            (bytes.as_ptr(), bytes.len())
+        };
+        unsafe {
+            let ptr = rebForeignHandle(
+                data as *const c_void,
+                size as size_t,
+                Some(drop_owner::<T>),
+                Box::into_raw(owner) as *mut c_void,
+            );
+            Value::from_raw(ptr).unwrap()
+        }
+    }
+
+    #[inline]
+    pub fn to_i64(&self) -> i64 {
+        self.borrow().to_i64()
+    }
+
+    #[inline]
+    pub fn to_f64(&self) -> f64 {
+        self.borrow().to_f64()
+    }
+
+    #[inline]
+    pub fn to_bool(&self) -> bool {
+        self.borrow().to_bool()
+    }
+
+    #[inline]
+    pub fn to_string(&self) -> String {
+        self.borrow().to_string()
+    }
+
+    #[inline]
+    pub fn spell_into(&self, out: &mut String) {
+        self.borrow().spell_into(out)
+    }
+
+    #[inline]
+    pub fn bytes_into(&self, out: &mut Vec<u8>) {
+        self.borrow().bytes_into(out)
+    }
+
+    #[inline]
+    pub fn handle_bytes(&self) -> Option<&[u8]> {
+        self.borrow().handle_bytes()
+    }
+
+    /// # Safety
+    ///
+    /// See [`ValueRef::text_view`].
+    #[inline]
+    pub unsafe fn text_view(&self) -> Option<TextView<'_>> {
+        self.borrow().text_view()
+    }
+
+    /// # Safety
+    ///
+    /// See [`ValueRef::binary_view`].
+    #[inline]
+    pub unsafe fn binary_view(&self) -> Option<BinaryView<'_>> {
+        self.borrow().binary_view()
+    }
+}
+
+impl Drop for Value {
+    #[inline]
+    fn drop(&mut self) {
+        unsafe { rebRelease(self.ptr.as_ptr()) }
+    }
+}
+
+impl<'a> ValueRef<'a> {
+    /// Borrow a handle owned by something else (e.g. the core, or a raw
+    /// caller), which must outlive `'a`.
+    #[inline]
+    pub unsafe fn from_raw(ptr: *const Reb_Value) -> Option<ValueRef<'a>> {
+        NonNull::new(ptr as *mut Reb_Value).map(|ptr| ValueRef { ptr, _borrow: PhantomData })
+    }
+
+    #[inline]
+    pub fn as_ptr(self) -> *const Reb_Value {
+        self.ptr.as_ptr()
+    }
+
+    /// INTEGER! as i64.
+    #[inline]
+    pub fn to_i64(self) -> i64 {
+        unsafe { rebUnboxInteger0(self.as_ptr() as *const c_void) as i64 }
+    }
+
+    /// DECIMAL! (or INTEGER!) as f64.
+    #[inline]
+    pub fn to_f64(self) -> f64 {
+        unsafe { rebUnboxDecimal(self.as_ptr() as *const c_void, feed::END) }
+    }
+
+    /// Rebol truthiness, as `rebDid()`.
+    #[inline]
+    pub fn to_bool(self) -> bool {
+        unsafe { rebDid(self.as_ptr() as *const c_void, feed::END) }
+    }
+
+    /// Spelling of an ANY-STRING! or ANY-WORD!, in a `String` allocated
+    /// once, at its exact size.
+    #[inline]
+    pub fn to_string(self) -> String {
+        let mut s = String::new();
+        self.spell_into(&mut s);
+        s
+    }
+
+    /// Like `to_string()`, but into an existing `String`, which only has
+    /// to allocate if it is too small.
+    #[inline]
+    pub fn spell_into(self, out: &mut String) {
+        unsafe { feed::spell_into(out, &[self.as_ptr() as *const c_void]) }
+    }
+
+    /// Bytes of a BINARY! into an existing `Vec`, which only has to
+    /// allocate if it is too small.
+    #[inline]
+    pub fn bytes_into(self, out: &mut Vec<u8>) {
+        unsafe { feed::bytes_into(out, &[self.as_ptr() as *const c_void]) }
+    }
+
+    /// Data of a HANDLE! made by `Value::handle()`; `None` if it isn't
+    /// one, including for HANDLE!s made by the core or by other code.
+    pub fn handle_bytes(self) -> Option<&'a [u8]> {
+        unsafe {
+            let mut size: size_t = 0;
+            let data = rebHandleBytes(&mut size, self.as_ptr());
+            if data.is_null() {
+                None
+            } else if size == 0 {
+                Some(&[])
+            } else {
+                Some(std::slice::from_raw_parts(data, size as usize))
+            }
+        }
+    }
+
+    /// Borrow a TEXT!'s UTF-8 in place; `None` if it isn't a TEXT!.
+    ///
+    /// # Safety
+    ///
+    /// No Rebol code that unprotects the TEXT! may run while the view is
+    /// open; see the [`view`](crate::view#safety) module.
+    #[inline]
+    pub unsafe fn text_view(self) -> Option<TextView<'a>> {
+        TextView::new(self)
+    }
+
+    /// Borrow a BINARY!'s bytes in place; `None` if it isn't a BINARY!.
+    ///
+    /// # Safety
+    ///
+    /// No Rebol code that unprotects the BINARY! may run while the view is
+    /// open; see the [`view`](crate::view#safety) module.
+    #[inline]
+    pub unsafe fn binary_view(self) -> Option<BinaryView<'a>> {
+        BinaryView::new(self)
+    }
+}
@@ -0,0 +1,111 @@
+//! Zero-copy views of TEXT! and BINARY! contents.
+//!
+//! `to_string()` and `bytes_into()` copy out of the series.  A view instead
+//! borrows its bytes in place for as long as the view lives, which is bound
+//! to the lifetime of the value it was taken from.  The shim PROTECTs the
+//! series while any view of it is open, so Rebol code that tries to modify
+//! it raises an error rather than moving the data out from under the borrow.
+//!
+//! That PROTECT is an ordinary one, though, and Rebol code can UNPROTECT
+//! the series and then resize it, leaving the view dangling.  So opening a
+//! view is `unsafe`.
+//!
+//! # Safety
+//!
+//! While a view is open, no Rebol code may run that unprotects the series
+//! it borrows.  Views of one series may be dropped in any order.
+
+use crate::*;
+use std::marker::PhantomData;
+use std::ops::Deref;
+
+struct View<'a> {
+    view: REBVIEW,
+    _borrow: PhantomData<ValueRef<'a>>,
+}
+
+impl<'a> View<'a> {
+    fn open(value: ValueRef<'a>, want_text: bool) -> Option<View<'a>> {
+        unsafe {
+            let mut view: REBVIEW = std::mem::zeroed();
+            if !rebOpenView(&mut view, value.as_ptr()) {
+                return None;
+            }
+            let view = View { view, _borrow: PhantomData };
+            if view.view.is_text != want_text {
+                return None; // closed by drop
+            }
+            Some(view)
+        }
+    }
+
+    #[inline]
+    fn as_bytes(&self) -> &[u8] {
+        if self.view.size == 0 {
+            return &[];
+        }
+        unsafe { std::slice::from_raw_parts(self.view.data, self.view.size as usize) }
+    }
+}
+
+impl<'a> Drop for View<'a> {
+    #[inline]
+    fn drop(&mut self) {
+        unsafe { rebCloseView(&mut self.view) }
+    }
+}
+
+/// The UTF-8 of a TEXT!, from its position to its tail.
+pub struct TextView<'a>(View<'a>);
+
+impl<'a> TextView<'a> {
+    /// # Safety
+    ///
+    /// See the [module docs](self#safety).
+    #[inline]
+    pub unsafe fn new(value: ValueRef<'a>) -> Option<TextView<'a>> {
+        View::open(value, true).map(TextView)
+    }
+
+    #[inline]
+    pub fn as_str(&self) -> &str {
+        // Rebol text is always valid UTF-8.
+        unsafe { std::str::from_utf8_unchecked(self.0.as_bytes()) }
+    }
+}
+
+impl<'a> Deref for TextView<'a> {
+    type Target = str;
+
+    #[inline]
+    fn deref(&self) -> &str {
+        self.as_str()
+    }
+}
+
+/// The bytes of a BINARY!, from its position to its tail.
+pub struct BinaryView<'a>(View<'a>);
+
+impl<'a> BinaryView<'a> {
+    /// # Safety
+    ///
+    /// See the [module docs](self#safety).
+    #[inline]
+    pub unsafe fn new(value: ValueRef<'a>) -> Option<BinaryView<'a>> {
+        View::open(value, false).map(BinaryView)
+    }
+
+    #[inline]
+    pub fn as_bytes(&self) -> &[u8] {
+        self.0.as_bytes()
+    }
+}
+
+impl<'a> Deref for BinaryView<'a> {
+    type Target = [u8];
+
+    #[inline]
+    fn deref(&self) -> &[u8] {
+        self.as_bytes()
+    }
+}
@@ -0,0 +1,8 @@
+/*
+ * Input to bindgen (see %build.rs): the libRebol header, plus the real
+ * (non-macro) entry points exported by the shim.
+ */
+#define REBOL_DISABLE_ACCESSOR_MACROS
+#include "renc/include/rebol.h"
+#include "renc/shim/valist.h"
+#include "renc/shim/codec.h"